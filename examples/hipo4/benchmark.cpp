@@ -0,0 +1,76 @@
+/*
+ * Benchmark of bank lookups in an event. For every event the position of
+ * every bank in the dictionary is looked up, once by walking the structure
+ * headers of the event for each bank (the way events used to do it) and
+ * once through the event's structure index, which is built once per event.
+ */
+#include "hipo4/reader.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+// linear walk over the structure headers, for reference
+std::pair<int, int> linearPosition(hipo::event& event, int group, int item) {
+  std::vector<char>& buffer   = event.getEventBuffer();
+  int                position = 16;
+  int                size     = event.getSize();
+  while (position + 8 < size) {
+    uint16_t gid    = *(reinterpret_cast<uint16_t*>(&buffer[position]));
+    uint8_t  iid    = *(reinterpret_cast<uint8_t*>(&buffer[position + 2]));
+    int      length = *(reinterpret_cast<int*>(&buffer[position + 4]));
+    if (gid == group && iid == item)
+      return std::make_pair(position, length);
+    position += (length + 8);
+  }
+  return std::make_pair(-1, 0);
+}
+
+int main(int argc, char** argv) {
+
+  if (argc < 2) {
+    std::cerr << " *** please provide a file name..." << std::endl;
+    exit(1);
+  }
+
+  hipo::reader reader;
+  reader.open(argv[1]);
+  hipo::dictionary factory;
+  reader.readDictionary(factory);
+
+  std::vector<std::pair<int, int>> banks;
+  std::vector<std::string>         schemaList = factory.getSchemaList();
+  for (auto& name : schemaList) {
+    hipo::schema& schema = factory.getSchema(name);
+    banks.push_back(std::make_pair(schema.getGroup(), schema.getItem()));
+  }
+
+  hipo::event event;
+  long        found[2] = {0, 0};
+  double      time[2]  = {0, 0};
+  long        nevents  = 0;
+
+  while (reader.next() == true) {
+    reader.read(event);
+    nevents++;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto& bank : banks) {
+      if (linearPosition(event, bank.first, bank.second).first > 0)
+        found[0]++;
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+    // reading the buffer above invalidated the index, it is rebuilt here
+    for (auto& bank : banks) {
+      if (event.getStructurePosition(bank.first, bank.second).first > 0)
+        found[1]++;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    time[0] += std::chrono::duration<double>(middle - start).count();
+    time[1] += std::chrono::duration<double>(end - middle).count();
+  }
+
+  printf("events = %ld, banks in dictionary = %lu\n", nevents, banks.size());
+  printf("  linear scan     : %10.6f sec (found %ld)\n", time[0], found[0]);
+  printf("  structure index : %10.6f sec (found %ld)\n", time[1], found[1]);
+}
@@ -1,6 +1,5 @@
 #include "hipo4/reader.h"
 #include "hipo4/writer.h"
-#include <TMath.h>
 #include <cstdlib>
 #include <iostream>
 
@@ -16,9 +15,15 @@ int main(int argc, char** argv) {
 
   hipo::bank particles(factory.getSchema("REC::Particle"));
 
+  // electrons with a track in the drift chambers
+  hipo::selection electrons;
+  electrons.equal("pid", 11).absRange("status", 2000, 4000);
+  std::vector<uint8_t> mask;
+
   myWriter.getDictionary().addSchema(factory.getSchema("RUN::config"));
   myWriter.getDictionary().addSchema(factory.getSchema("REC::Event"));
   myWriter.getDictionary().addSchema(factory.getSchema("REC::Particle"));
+  myWriter.setBackground(true);
   myWriter.open(argv[2]);
   hipo::event event;
 
@@ -29,19 +34,7 @@ int main(int argc, char** argv) {
 
     event.getStructure(particles);
 
-    int nrows = particles.getRows();
-
-    bool isSelected = false;
-    for (int row = 0; row < nrows && !isSelected; row++) {
-      int  pid    = particles.getInt("pid", row);
-      int  status = particles.getInt("status", row);
-      int  stat   = TMath::Abs(status);
-      bool inDC   = (stat >= 2000 && stat < 4000);
-
-      if (pid == 11 && inDC) {
-        isSelected = true;
-      }
-    }
+    bool isSelected = particles.select(electrons, mask) > 0;
     if (isSelected) {
       Nwritten++;
       myWriter.addEvent(event);
@@ -0,0 +1,46 @@
+#include "hipo4/reader.h"
+#include <cstdlib>
+#include <iostream>
+
+// per-thread state, every thread gets its own copy of the bank
+struct electronCount {
+  hipo::bank particles;
+  long       events    = 0;
+  long       electrons = 0;
+};
+
+int main(int argc, char** argv) {
+
+  if (argc < 2) {
+    std::cerr << " *** please provide a file name..." << std::endl;
+    exit(1);
+  }
+  int nthreads = (argc > 2) ? atoi(argv[2]) : 0;
+
+  hipo::reader reader;
+  reader.open(argv[1]);
+  hipo::dictionary factory;
+  reader.readDictionary(factory);
+
+  electronCount init;
+  init.particles = hipo::bank(factory.getSchema("REC::Particle"));
+
+  electronCount total = reader.forEachParallel(
+      nthreads, init,
+      [](hipo::event& event, electronCount& count) {
+        event.getStructure(count.particles);
+        count.events++;
+        int nrows = count.particles.getRows();
+        for (int row = 0; row < nrows; row++) {
+          int status = abs(count.particles.getInt("status", row));
+          if (count.particles.getInt("pid", row) == 11 && status >= 2000 && status < 4000)
+            count.electrons++;
+        }
+      },
+      [](electronCount& total, electronCount& partial) {
+        total.events += partial.events;
+        total.electrons += partial.electrons;
+      });
+
+  printf("processed events = %ld, electrons = %ld\n", total.events, total.electrons);
+}
@@ -338,6 +338,9 @@ int main(int argc, char** argv) {
   bool        cov        = false;
   bool        traj       = false;
   float       max_size   = 1500;
+  int         prefetch   = 0;
+  bool        streaming  = false;
+  bool        direct_io  = false;
 
   auto cli = (clipp::option("-h", "--help").set(print_help) % "print help",
               clipp::option("-mc", "--MC").set(is_mc) % "Convert dst and mc banks",
@@ -351,6 +354,13 @@ int main(int argc, char** argv) {
               clipp::option("-test", "--test").set(is_test) % "Testing",
               clipp::option("-m", "--max_file_size") &
                   clipp::value("max_size", max_size) % "Max file size in GB (150GB default)",
+              clipp::option("-p", "--prefetch") &
+                  clipp::value("records", prefetch) %
+                      "Number of records to read ahead in the background (0 default)",
+              clipp::option("-s", "--streaming").set(streaming) %
+                  "Drop pages of the input file from the page cache after reading them",
+              clipp::option("-d", "--direct").set(direct_io) %
+                  "Read the input file with O_DIRECT, bypassing the page cache",
               clipp::value("inputFile.hipo", InFileName),
               clipp::opt_value("outputFile.root", OutFileName));
 
@@ -374,36 +384,79 @@ int main(int argc, char** argv) {
 
   auto   reader          = std::make_shared<hipo::reader>(InFileName);
   size_t tot_hipo_events = reader->numEvents();
+  reader->setPrefetch(prefetch);
+  if (direct_io)
+    reader->setPageCachePolicy(hipo::kPageCacheDirect);
+  else if (streaming)
+    reader->setPageCachePolicy(hipo::kPageCacheStreaming);
 
   auto dict = std::make_shared<hipo::dictionary>();
   reader->readDictionary(*dict);
-  auto hipo_event = std::make_shared<hipo::event>();
+  auto hipo_event = std::make_shared<hipo::eventView>();
 
   // Event config
-  auto run_Config = std::make_shared<hipo::bank>(dict->getSchema("RUN::config"));
-  auto rec_Event  = std::make_shared<hipo::bank>(dict->getSchema("REC::Event"));
-  auto hel_Flip   = std::make_shared<hipo::bank>(dict->getSchema("HEL::flip"));
+  auto run_Config = std::make_shared<hipo::bankView>(dict->getSchema("RUN::config"));
+  auto rec_Event  = std::make_shared<hipo::bankView>(dict->getSchema("REC::Event"));
+  auto hel_Flip   = std::make_shared<hipo::bankView>(dict->getSchema("HEL::flip"));
 
   // Physics
-  auto rec_Particle      = std::make_shared<hipo::bank>(dict->getSchema("REC::Particle"));
-  auto rec_Calorimeter   = std::make_shared<hipo::bank>(dict->getSchema("REC::Calorimeter"));
-  auto rec_Scintillator  = std::make_shared<hipo::bank>(dict->getSchema("REC::Scintillator"));
-  auto rec_ScintExtras   = std::make_shared<hipo::bank>(dict->getSchema("REC::ScintExtras"));
-  auto rec_Cherenkov     = std::make_shared<hipo::bank>(dict->getSchema("REC::Cherenkov"));
-  auto rec_Track         = std::make_shared<hipo::bank>(dict->getSchema("REC::Track"));
-  auto rec_ForwardTagger = std::make_shared<hipo::bank>(dict->getSchema("REC::ForwardTagger"));
-  auto rec_Traj          = std::make_shared<hipo::bank>(dict->getSchema("REC::Traj"));
-  auto rec_CovMat        = std::make_shared<hipo::bank>(dict->getSchema("REC::CovMat"));
+  auto rec_Particle      = std::make_shared<hipo::bankView>(dict->getSchema("REC::Particle"));
+  auto rec_Calorimeter   = std::make_shared<hipo::bankView>(dict->getSchema("REC::Calorimeter"));
+  auto rec_Scintillator  = std::make_shared<hipo::bankView>(dict->getSchema("REC::Scintillator"));
+  auto rec_ScintExtras   = std::make_shared<hipo::bankView>(dict->getSchema("REC::ScintExtras"));
+  auto rec_Cherenkov     = std::make_shared<hipo::bankView>(dict->getSchema("REC::Cherenkov"));
+  auto rec_Track         = std::make_shared<hipo::bankView>(dict->getSchema("REC::Track"));
+  auto rec_ForwardTagger = std::make_shared<hipo::bankView>(dict->getSchema("REC::ForwardTagger"));
+  auto rec_Traj          = std::make_shared<hipo::bankView>(dict->getSchema("REC::Traj"));
+  auto rec_CovMat        = std::make_shared<hipo::bankView>(dict->getSchema("REC::CovMat"));
+
+  // Column handles for the particle loop, resolved once
+  auto part_pid     = rec_Particle->getColumn<int32_t>("pid");
+  auto part_px      = rec_Particle->getColumn<float>("px");
+  auto part_py      = rec_Particle->getColumn<float>("py");
+  auto part_pz      = rec_Particle->getColumn<float>("pz");
+  auto part_vx      = rec_Particle->getColumn<float>("vx");
+  auto part_vy      = rec_Particle->getColumn<float>("vy");
+  auto part_vz      = rec_Particle->getColumn<float>("vz");
+  auto part_charge  = rec_Particle->getColumn<int8_t>("charge");
+  auto part_beta    = rec_Particle->getColumn<float>("beta");
+  auto part_chi2pid = rec_Particle->getColumn<float>("chi2pid");
+  auto part_status  = rec_Particle->getColumn<int16_t>("status");
+  if (!part_pid.isValid() || !part_px.isValid() || !part_py.isValid() || !part_pz.isValid() ||
+      !part_vx.isValid() || !part_vy.isValid() || !part_vz.isValid() || !part_charge.isValid() ||
+      !part_beta.isValid() || !part_chi2pid.isValid() || !part_status.isValid()) {
+    std::cerr << "REC::Particle in " << InFileName << " does not have the expected columns"
+              << std::endl;
+    exit(1);
+  }
 
   // ForwardTagger
-  auto recft_Particle = std::make_shared<hipo::bank>(dict->getSchema("RECFT::Particle"));
-  auto recft_Event    = std::make_shared<hipo::bank>(dict->getSchema("RECFT::Event"));
+  auto recft_Particle = std::make_shared<hipo::bankView>(dict->getSchema("RECFT::Particle"));
+  auto recft_Event    = std::make_shared<hipo::bankView>(dict->getSchema("RECFT::Event"));
 
   // Monte Carlo only banks
-  auto mc_Header   = std::make_shared<hipo::bank>(dict->getSchema("MC::Header"));
-  auto mc_Event    = std::make_shared<hipo::bank>(dict->getSchema("MC::Event"));
-  auto mc_Particle = std::make_shared<hipo::bank>(dict->getSchema("MC::Particle"));
-  auto mc_Lund     = std::make_shared<hipo::bank>(dict->getSchema("MC::Lund"));
+  auto mc_Header   = std::make_shared<hipo::bankView>(dict->getSchema("MC::Header"));
+  auto mc_Event    = std::make_shared<hipo::bankView>(dict->getSchema("MC::Event"));
+  auto mc_Particle = std::make_shared<hipo::bankView>(dict->getSchema("MC::Particle"));
+  auto mc_Lund     = std::make_shared<hipo::bankView>(dict->getSchema("MC::Lund"));
+
+  // only the converted banks are decompressed from columnar files
+  std::vector<std::string> banks = {"RUN::config",    "REC::Event",         "HEL::flip",
+                                    "REC::Particle",  "REC::Calorimeter",   "REC::Scintillator",
+                                    "REC::Cherenkov", "REC::ScintExtras",   "REC::Track",
+                                    "RECFT::Event",   "REC::ForwardTagger", "RECFT::Particle"};
+  if (traj)
+    banks.push_back("REC::Traj");
+  if (cov)
+    banks.push_back("REC::CovMat");
+  if (is_mc)
+    banks.insert(banks.end(), {"MC::Header", "MC::Event", "MC::Particle", "MC::Lund"});
+  std::vector<std::string> banksToRead;
+  for (auto& name : banks) {
+    if (dict->hasSchema(name.c_str()))
+      banksToRead.push_back(name);
+  }
+  reader->setBanks(banksToRead);
 
   init(clas12, is_mc, cov, traj);
 
@@ -555,23 +608,20 @@ int main(int argc, char** argv) {
       status.resize(len_pid);
 
       for (int i = 0; i < len_pid; i++) {
-        pid[i]    = rec_Particle->getInt("pid", i);
-        p2[i]     = (rec_Particle->getFloat("px", i) * rec_Particle->getFloat("px", i) +
-                 rec_Particle->getFloat("py", i) * rec_Particle->getFloat("py", i) +
-                 rec_Particle->getFloat("pz", i) * rec_Particle->getFloat("pz", i));
-        p[i]      = sqrt(p2[i]);
-        px[i]     = rec_Particle->getFloat("px", i);
-        py[i]     = rec_Particle->getFloat("py", i);
-        pz[i]     = rec_Particle->getFloat("pz", i);
-        vx[i]     = rec_Particle->getFloat("vx", i);
-        vy[i]     = rec_Particle->getFloat("vy", i);
-        vz[i]     = rec_Particle->getFloat("vz", i);
-        vt[i]     = rec_Particle->getFloat("vt", i);
-        charge[i] = rec_Particle->getInt("charge", i);
-        beta[i] = ((rec_Particle->getFloat("beta", i) != -9999) ? rec_Particle->getFloat("beta", i)
-                                                                : NAN);
-        chi2pid[i] = rec_Particle->getFloat("chi2pid", i);
-        status[i]  = rec_Particle->getInt("status", i);
+        pid[i]     = part_pid[i];
+        px[i]      = part_px[i];
+        py[i]      = part_py[i];
+        pz[i]      = part_pz[i];
+        p2[i]      = px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i];
+        p[i]       = sqrt(p2[i]);
+        vx[i]      = part_vx[i];
+        vy[i]      = part_vy[i];
+        vz[i]      = part_vz[i];
+        vt[i]      = rec_Particle->getFloat("vt", i);
+        charge[i]  = part_charge[i];
+        beta[i]    = ((part_beta[i] != -9999) ? part_beta[i] : NAN);
+        chi2pid[i] = part_chi2pid[i];
+        status[i]  = part_status[i];
       }
     }
 
@@ -14,6 +14,7 @@
 #ifndef HIPO_BANK_H
 #define HIPO_BANK_H
 #include "dictionary.h"
+#include "selection.h"
 #include <cmath>
 #include <cstring>
 #include <iostream>
@@ -26,6 +27,67 @@
 
 namespace hipo {
 
+  /**
+   * maps the C++ type to the type id used in the schema entries,
+   * B=int8_t, S=int16_t, I=int32_t, F=float, D=double, L=int64_t.
+   */
+  template <typename T>
+  struct columnType {
+    static const int id = -1;
+  };
+  template <>
+  struct columnType<int8_t> {
+    static const int id = 1;
+  };
+  template <>
+  struct columnType<int16_t> {
+    static const int id = 2;
+  };
+  template <>
+  struct columnType<int32_t> {
+    static const int id = 3;
+  };
+  template <>
+  struct columnType<float> {
+    static const int id = 4;
+  };
+  template <>
+  struct columnType<double> {
+    static const int id = 5;
+  };
+  template <>
+  struct columnType<int64_t> {
+    static const int id = 8;
+  };
+
+  /**
+   * Non-owning view of a contiguous array of values, used to expose a
+   * bank column (columns are stored contiguously in HIPO4 banks).
+   */
+  template <typename T>
+  class span {
+  private:
+    const T* spanData;
+    int      spanSize;
+
+  public:
+    span() {
+      spanData = NULL;
+      spanSize = 0;
+    }
+    span(const T* data, int size) {
+      spanData = data;
+      spanSize = size;
+    }
+
+    const T* data() const { return spanData; }
+    int      size() const { return spanSize; }
+    bool     empty() const { return spanSize == 0; }
+    const T* begin() const { return spanData; }
+    const T* end() const { return spanData + spanSize; }
+    const T& operator[](int index) const { return spanData[index]; }
+  };
+
   class structure {
 
   private:
@@ -50,7 +112,7 @@ namespace hipo {
     int          getGroup();
     int          getItem();
     void         init(const char* buffer, int size);
-    const char*  getAddress();
+    const char*  getAddress() { return structureAddress; }
     virtual void show();
     void         setSize(int size);
 
@@ -99,6 +161,7 @@ namespace hipo {
 
     virtual void notify() {}
     friend class event;
+    friend class eventView;
   };
 
   class bank : public hipo::structure {
@@ -107,6 +170,13 @@ namespace hipo {
     hipo::schema bankSchema;
     int          bankRows;
 
+    template <typename S, typename T>
+    static void convertColumn(const char* source, T* out, int rows) {
+      const S* values = reinterpret_cast<const S*>(source);
+      for (int i = 0; i < rows; i++)
+        out[i] = static_cast<T>(values[i]);
+    }
+
   protected:
     void setBankRows(int rows) { bankRows = rows; }
 
@@ -136,6 +206,65 @@ namespace hipo {
     int  getRows() { return bankRows; }
     void setRows(int rows);
 
+    /**
+     * Handle to one column of the bank, resolved once by name with
+     * getColumn<T>(name). The handle knows the type and the offset of the
+     * column in a row, so element access is a direct load without name
+     * lookup or type switch, always reading the current content of the
+     * bank. T must be the storage type of the column (see columnType).
+     * getColumn() returns an invalid handle (isValid() false, size() 0)
+     * for a wrong name or type, which must not be indexed.
+     */
+    template <typename T>
+    class column {
+    private:
+      hipo::bank* columnBank;
+      int         columnOffset;
+
+    public:
+      column() {
+        columnBank   = NULL;
+        columnOffset = 0;
+      }
+      column(hipo::bank* b, int offset) {
+        columnBank   = b;
+        columnOffset = offset;
+      }
+
+      bool isValid() const { return columnBank != NULL; }
+      int  size() const { return columnBank != NULL ? columnBank->bankRows : 0; }
+      T    operator[](int row) const {
+        const char* data =
+            columnBank->getAddress() + 8 + columnBank->bankRows * columnOffset;
+        return reinterpret_cast<const T*>(data)[row];
+      }
+    };
+
+    /**
+     * returns true if the bank has the column, prints an error otherwise.
+     */
+    bool checkColumn(const char* name) {
+      if (bankSchema.hasEntry(name) == true)
+        return true;
+      std::cerr << "---> error : bank [" << bankSchema.getName() << "] has no column [" << name
+                << "]" << std::endl;
+      return false;
+    }
+
+    template <typename T>
+    column<T> getColumn(const char* name) {
+      if (checkColumn(name) == false)
+        return column<T>();
+      int item = bankSchema.getEntryOrder(name);
+      if (bankSchema.getEntryType(item) != columnType<T>::id) {
+        std::cerr << "---> error : column [" << name << "] has type "
+                  << bankSchema.getEntryType(item) << ", requested " << columnType<T>::id
+                  << std::endl;
+        return column<T>();
+      }
+      return column<T>(this, bankSchema.getEntryOffset(item));
+    }
+
     template <typename T>
     T get(int item, int index) {
       int type   = bankSchema.getEntryType(item);
@@ -167,6 +296,82 @@ namespace hipo {
       return this->get<T>(item, index);
     }
 
+    /**
+     * Returns a view of the whole column, the column data is contiguous
+     * in the bank so no data is copied. T must be the storage type of
+     * the column, otherwise an empty span is returned. The span is valid
+     * until the content of the bank changes.
+     */
+    template <typename T>
+    hipo::span<T> getSpan(int item) {
+      if (bankSchema.getEntryType(item) != columnType<T>::id) {
+        std::cerr << "---> error : column [" << bankSchema.getEntryName(item) << "] has type "
+                  << bankSchema.getEntryType(item) << ", requested " << columnType<T>::id
+                  << std::endl;
+        return hipo::span<T>();
+      }
+      int offset = bankSchema.getOffset(item, 0, bankRows);
+      return hipo::span<T>(reinterpret_cast<const T*>(getAddress() + 8 + offset), bankRows);
+    }
+
+    template <typename T>
+    hipo::span<T> getSpan(const char* name) {
+      if (checkColumn(name) == false)
+        return hipo::span<T>();
+      return getSpan<T>(bankSchema.getEntryOrder(name));
+    }
+
+    /**
+     * Copies the whole column into out (which must hold getRows() values)
+     * and returns the number of values copied. If T is the storage type
+     * of the column this is a single memcpy, otherwise the values are
+     * converted (e.g. int8 to int32, or int to float).
+     */
+    template <typename T>
+    int copyColumn(int item, T* out) {
+      if (bankRows <= 0)
+        return 0;
+      const char* source = getAddress() + 8 + bankSchema.getOffset(item, 0, bankRows);
+      int         type   = bankSchema.getEntryType(item);
+      if (type == columnType<T>::id) {
+        std::memcpy(out, source, bankRows * sizeof(T));
+        return bankRows;
+      }
+      switch (type) {
+      case 1:
+        convertColumn<int8_t>(source, out, bankRows);
+        break;
+      case 2:
+        convertColumn<int16_t>(source, out, bankRows);
+        break;
+      case 3:
+        convertColumn<int32_t>(source, out, bankRows);
+        break;
+      case 4:
+        convertColumn<float>(source, out, bankRows);
+        break;
+      case 5:
+        convertColumn<double>(source, out, bankRows);
+        break;
+      case 8:
+        convertColumn<int64_t>(source, out, bankRows);
+        break;
+      default:
+        return 0;
+      }
+      return bankRows;
+    }
+
+    template <typename T>
+    int copyColumn(const char* name, T* out) {
+      if (checkColumn(name) == false)
+        return 0;
+      return copyColumn<T>(bankSchema.getEntryOrder(name), out);
+    }
+
+    int select(const hipo::selection& sel, std::vector<uint8_t>& mask);
+    int select(const hipo::selection& sel, std::vector<int>& rows);
+
     int       getInt(int item, int index);
     int       getShort(int item, int index);
     int       getByte(int item, int index);
@@ -205,5 +410,19 @@ namespace hipo {
     virtual void notify();
   };
 
+  /**
+   * Bank that does not own its data. It is filled by eventView::getStructure
+   * and points directly into the record buffer (or memory mapped file), so
+   * reading a bank costs no copy. The content is only valid until the
+   * record the event view was taken from changes, and it must not be
+   * modified with the put methods.
+   */
+  class bankView : public hipo::bank {
+  public:
+    bankView() {}
+    bankView(hipo::schema __schema) : bank(__schema) {}
+    ~bankView() {}
+  };
+
 } // namespace hipo
 #endif /* EVENT_H */
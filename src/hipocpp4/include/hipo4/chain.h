@@ -0,0 +1,172 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   chain.h
+ *
+ * Chain of HIPO files read as one sequence of events. Every file is
+ * opened once when it is added, to read its header, record index and
+ * compression dictionary, which are kept to reopen it. A global index
+ * maps event numbers of the chain to the files. Only the file being read
+ * is kept open, so long chains do not hold a reader (stream, record
+ * buffers) per file.
+ */
+
+#ifndef HIPO_CHAIN_H
+#define HIPO_CHAIN_H
+
+#include "reader.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace hipo {
+
+  // what the chain keeps of every file, see chain.h
+  typedef struct {
+    std::string                  name;
+    long                         size;
+    hipo::fileHeader_t           header;
+    hipo::readerIndex            index;
+    std::shared_ptr<hipo::codec> dictionaryCodec;
+  } chainFile_t;
+
+  class chain {
+  private:
+    std::vector<hipo::chainFile_t> chainFiles;
+    // cumulative number of events, starts with 0, one entry per file after that
+    std::vector<long> fileEvents;
+    std::vector<long> tagsToRead;
+    // dictionary of the first file, all files are expected to share it
+    hipo::dictionary chainDictionary;
+
+    bool useMemoryMap  = false;
+    int  prefetchDepth = 0;
+
+    // reader of the current file only
+    std::unique_ptr<hipo::reader> currentReader;
+
+    int  currentFile;
+    long currentEvent;
+    // records that could not be read, in the files already left and by
+    // forEachParallel
+    long failedRecords = 0;
+
+    void setOptions(hipo::reader& r);
+    void setFile(int fileNumber);
+
+  public:
+    chain();
+    chain(const char* pattern) : chain() { add(pattern); }
+    chain(const std::vector<std::string>& files) : chain() { add(files); }
+    ~chain() {}
+
+    int  add(const char* pattern);
+    int  add(const std::string& pattern) { return add(pattern.c_str()); }
+    int  add(const std::vector<std::string>& files);
+    void setTags(int tag) { tagsToRead.push_back(tag); }
+    void setMemoryMapped(bool flag) { useMemoryMap = flag; }
+    void setPrefetch(int depth) { prefetchDepth = depth; }
+
+    void readDictionary(hipo::dictionary& dict);
+    bool next();
+    bool next(hipo::event& dataevent);
+    void read(hipo::event& dataevent);
+    void read(hipo::eventView& dataevent);
+    bool gotoEvent(long eventNumber);
+    bool readEvent(long eventNumber, hipo::event& dataevent);
+    void rewind();
+
+    long        numEvents() { return fileEvents.back(); }
+    int         numFiles() { return chainFiles.size(); }
+    long        getEventNumber() { return currentEvent; }
+    int         getFileNumber() { return currentFile; }
+    std::string getFileName(int fileNumber) { return chainFiles[fileNumber].name; }
+    long        getFailedRecords();
+
+    hipo::reader& getReader(int fileNumber);
+
+    template <typename T, typename Process, typename Reduce>
+    T forEachParallel(int nthreads, T init, Process process, Reduce reduce);
+  };
+
+  /**
+   * Same as reader::forEachParallel, but the records of all files in the
+   * chain are handed out to the threads, so the work is balanced across
+   * file boundaries. Records that can not be read are skipped and added
+   * to getFailedRecords(), as are files that can not be opened.
+   */
+  template <typename T, typename Process, typename Reduce>
+  T chain::forEachParallel(int nthreads, T init, Process process, Reduce reduce) {
+    if (nthreads <= 0)
+      nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0)
+      nthreads = 1;
+
+    std::vector<std::pair<int, int>> records;
+    for (int f = 0; f < (int)chainFiles.size(); f++) {
+      int nrecords = chainFiles[f].index.getMaxRecords();
+      for (int r = 0; r < nrecords; r++)
+        records.push_back(std::make_pair(f, r));
+    }
+
+    int               nrecords = records.size();
+    std::atomic<int>  nextRecord(0);
+    std::atomic<long> failed(0);
+    std::vector<T>    results(nthreads, init);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < nthreads; t++) {
+      workers.push_back(std::thread([this, t, nrecords, &records, &nextRecord, &failed, &results,
+                                     &process] {
+        std::ifstream stream;
+        int           streamFile = -1;
+        T             local      = results[t];
+        hipo::record  rec;
+        hipo::event   event;
+        int           n;
+        while ((n = nextRecord++) < nrecords) {
+          const hipo::chainFile_t& file = chainFiles[records[n].first];
+          if (records[n].first != streamFile) {
+            if (stream.is_open() == true)
+              stream.close();
+            stream.clear();
+            stream.open(file.name.c_str(), std::ios::binary);
+            streamFile = records[n].first;
+            if (stream.is_open() == false)
+              std::cerr << "---> error : can not open file " << file.name << std::endl;
+          }
+          long position = file.index.getPosition(records[n].second);
+          rec.setDictionaryCodec(file.dictionaryCodec);
+          if (stream.is_open() == false ||
+              rec.readRecord(stream, position, 0, file.size) == false) {
+            std::cerr << "[WARNING] record " << records[n].second << " of " << file.name
+                      << " can not be read" << std::endl;
+            failed++;
+            continue;
+          }
+          int nevents = rec.getEventCount();
+          for (int i = 0; i < nevents; i++) {
+            rec.readHipoEvent(event, i);
+            process(event, local);
+          }
+        }
+        results[t] = std::move(local);
+      }));
+    }
+    for (auto& worker : workers)
+      worker.join();
+    failedRecords += failed;
+
+    T total = std::move(results[0]);
+    for (int t = 1; t < nthreads; t++)
+      reduce(total, results[t]);
+    return total;
+  }
+} // namespace hipo
+#endif /* HIPO_CHAIN_H */
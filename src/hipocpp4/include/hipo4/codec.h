@@ -0,0 +1,144 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   codec.h
+ *
+ * Record compression codecs. The compression type is stored in the top
+ * 4 bits of the compressed length word of the record header, readers
+ * look up the codec for that type in the registry to decompress, the
+ * writer creates one with the level configured for the file.
+ */
+
+#ifndef HIPO_CODEC_H
+#define HIPO_CODEC_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hipo {
+
+  // compression types as written in the record header
+  enum compressionType_t {
+    kCompressionNone    = 0,
+    kCompressionLZ4     = 1,
+    kCompressionLZ4HC   = 2,
+    kCompressionLZ4Dict = 4
+  };
+
+  class codec {
+  public:
+    virtual ~codec() {}
+
+    virtual int         getType() const = 0;
+    virtual std::string getName() const = 0;
+    /**
+     * compresses srcSize bytes into dst, returns the compressed size or
+     * 0 if the result does not fit in dstCapacity.
+     */
+    virtual int compress(const char* src, char* dst, int srcSize, int dstCapacity) const = 0;
+    /**
+     * decompresses srcSize bytes into dst, returns the decompressed size
+     * or a negative number if the data is corrupt.
+     */
+    virtual int decompress(const char* src, char* dst, int srcSize, int dstCapacity) const = 0;
+    /**
+     * decompresses what can be decoded of srcSize bytes that may be cut
+     * short, returns the decompressed size or a negative number if the
+     * codec can not decode partial data.
+     */
+    virtual int decompressPartial(const char* src, char* dst, int srcSize, int dstCapacity) const {
+      return -1;
+    }
+    /**
+     * sets the dictionary for codecs that use one, ignored by the others.
+     */
+    virtual void setDictionary(const char* data, int size) {}
+  };
+
+  class codecNone : public codec {
+  public:
+    int         getType() const { return kCompressionNone; }
+    std::string getName() const { return "none"; }
+    int         compress(const char* src, char* dst, int srcSize, int dstCapacity) const;
+    int         decompress(const char* src, char* dst, int srcSize, int dstCapacity) const;
+  };
+
+  class codecLZ4 : public codec {
+  private:
+    int acceleration;
+
+  public:
+    codecLZ4(int __acceleration = 3) { acceleration = __acceleration; }
+    int         getType() const { return kCompressionLZ4; }
+    std::string getName() const { return "lz4"; }
+    int         compress(const char* src, char* dst, int srcSize, int dstCapacity) const;
+    int         decompress(const char* src, char* dst, int srcSize, int dstCapacity) const;
+    int         decompressPartial(const char* src, char* dst, int srcSize, int dstCapacity) const;
+  };
+
+  class codecLZ4HC : public codec {
+  private:
+    int level;
+
+  public:
+    codecLZ4HC(int __level = 9) { level = __level; }
+    int         getType() const { return kCompressionLZ4HC; }
+    std::string getName() const { return "lz4hc"; }
+    int         compress(const char* src, char* dst, int srcSize, int dstCapacity) const;
+    int         decompress(const char* src, char* dst, int srcSize, int dstCapacity) const;
+  };
+
+  /**
+   * LZ4 with a dictionary shared by all records of a file (stored in the
+   * file user header), which keeps the compression ratio of small records
+   * close to the one of large records. Only the last 64 KB are used.
+   */
+  class codecLZ4Dict : public codec {
+  private:
+    int               acceleration;
+    std::vector<char> dictionary;
+
+  public:
+    codecLZ4Dict(int __acceleration = 3) { acceleration = __acceleration; }
+    int         getType() const { return kCompressionLZ4Dict; }
+    std::string getName() const { return "lz4dict"; }
+    int         compress(const char* src, char* dst, int srcSize, int dstCapacity) const;
+    int         decompress(const char* src, char* dst, int srcSize, int dstCapacity) const;
+    void        setDictionary(const char* data, int size) { dictionary.assign(data, data + size); }
+  };
+
+  /**
+   * Registry of codecs by compression type and name. The built-in codecs
+   * (none, lz4, lz4hc and lz4dict) are always there, others can be added at
+   * startup with add() before any file is read or written. The level is
+   * the LZ4 acceleration or the LZ4-HC compression level, a negative
+   * level takes the codec default.
+   */
+  class codecRegistry {
+  public:
+    typedef std::function<codec*(int level)> factory_t;
+
+    static void                   add(int type, const std::string& name, factory_t factory);
+    static std::shared_ptr<codec> create(int type, int level = -1);
+    static std::shared_ptr<codec> create(const std::string& name, int level = -1);
+    static const codec*           get(int type);
+    static int                    getType(const std::string& name);
+
+  private:
+    typedef struct {
+      std::string            name;
+      factory_t              factory;
+      std::shared_ptr<codec> instance;
+    } entry_t;
+
+    static std::map<int, entry_t>  builtin();
+    static std::map<int, entry_t>& entries();
+  };
+} // namespace hipo
+#endif /* HIPO_CODEC_H */
@@ -82,6 +82,8 @@ namespace hipo {
     int         getOffset(int item, int order, int rows);
     int         getOffset(const char* name, int order, int rows);
     int         getEntryType(int item) { return schemaEntries[item].typeId; }
+    int         getEntryOffset(int item) { return schemaEntries[item].offset; }
+    bool        hasEntry(const char* name) { return (schemaEntriesMap.count(name) != 0); }
     std::string getEntryName(int item) { return schemaEntries[item].name; }
     int         getEntries() { return schemaEntries.size(); }
     void        show();
@@ -34,10 +34,34 @@ namespace hipo {
 
   // typedef std::auto_ptr<hipo::generic_node> node_pointer;
 
+  /**
+   * Table of positions and lengths of all structures in an event, keyed
+   * by (group,item). It is built with a single pass over the structure
+   * headers on the first lookup, every following lookup is a hash lookup
+   * instead of a walk through the event. Has to be invalidated whenever
+   * the event content changes.
+   */
+  class eventIndex {
+
+  private:
+    robin_hood::unordered_flat_map<int, std::pair<int, int>> structurePositions;
+    bool                                                     indexValid;
+
+    void build(const char* buffer, int size);
+
+  public:
+    eventIndex() { indexValid = false; }
+    ~eventIndex() {}
+
+    void                invalidate() { indexValid = false; }
+    std::pair<int, int> find(const char* buffer, int size, int group, int item);
+  };
+
   class event {
 
   private:
     std::vector<char> dataBuffer;
+    hipo::eventIndex  structureIndex;
 
   public:
     event();
@@ -56,6 +80,32 @@ namespace hipo {
     int                 getSize();
     void                reset();
   };
+
+  /**
+   * Event that does not own its data, it points directly into the
+   * decompressed record buffer and is filled by reader::read(eventView&)
+   * without copying the event. It stays valid until the record changes,
+   * i.e. until the reader moves to an event in another record.
+   */
+  class eventView {
+
+  private:
+    const char*      eventData;
+    int              eventSize;
+    hipo::eventIndex structureIndex;
+
+  public:
+    eventView();
+    ~eventView() {}
+
+    void init(const char* buffer, int size);
+    void getStructure(hipo::bankView& b);
+    void getStructure(hipo::bank& b);
+
+    std::pair<int, int> getStructurePosition(int group, int item);
+    const char*         getEventData() { return eventData; }
+    int                 getSize() { return eventSize; }
+  };
   /*
   template<class T>   node<T> event::getNode(){
       node<T> en;
@@ -0,0 +1,105 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   filehandle.h
+ *
+ * Shared, read only view of an open HIPO file for multi-threaded
+ * reading. The file header, the record index (trailer), the schema
+ * dictionary and the compression dictionary are parsed once when the
+ * handle is opened and never change afterwards. Each thread reads
+ * events through its own fileCursor, which reads records with pread()
+ * on the descriptor of the handle, so cursors do not share a file
+ * offset and need no locking. Cursors can share a memory bounded LRU
+ * cache of decompressed records (setCacheSize()), so cursors visiting
+ * the same records (event mixing, joins) decompress them only once.
+ *
+ *   std::shared_ptr<hipo::fileHandle> handle = hipo::fileHandle::open("file.hipo");
+ *   // in every thread
+ *   hipo::fileCursor cursor(handle);
+ *   hipo::event      event;
+ *   while (cursor.next(event)) { ... }
+ */
+
+#ifndef HIPO_FILEHANDLE_H
+#define HIPO_FILEHANDLE_H
+
+#include "dictionary.h"
+#include "reader.h"
+#include "record.h"
+#include "recordcache.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hipo {
+
+  class fileHandle {
+  private:
+    std::string       fileName;
+    int               fileDescriptor = -1;
+    long              fileSize       = 0;
+    hipo::readerIndex recordIndex;
+    hipo::dictionary  schemaDictionary;
+    // codec with the LZ4 dictionary of the file (user header), if any
+    std::shared_ptr<hipo::codec> dictionaryCodec;
+    // decompressed records shared by the cursors, see setCacheSize()
+    mutable hipo::recordCache recordsCache;
+
+    fileHandle() {}
+
+  public:
+    ~fileHandle();
+
+    static std::shared_ptr<fileHandle> open(const std::string& filename,
+                                            const std::vector<long>& tags = std::vector<long>());
+
+    bool readRecord(hipo::record& rec, int recordNumber) const;
+    void readDictionary(hipo::dictionary& dict) const { dict = schemaDictionary; }
+
+    void setCacheSize(long bytes) { recordsCache.setMaxSize(bytes); }
+    bool isCacheEnabled() const { return recordsCache.isEnabled(); }
+    long getCacheHits() const { return recordsCache.getHits(); }
+    long getCacheMisses() const { return recordsCache.getMisses(); }
+
+    std::shared_ptr<hipo::record> getCachedRecord(int recordNumber) const;
+
+    const std::string&       getFileName() const { return fileName; }
+    long                     getFileSize() const { return fileSize; }
+    long                     numEvents() const { return recordIndex.getMaxEvents(); }
+    const hipo::readerIndex& getIndex() const { return recordIndex; }
+  };
+
+  class fileCursor {
+  private:
+    std::shared_ptr<const fileHandle> handle;
+    hipo::record                      cursorRecord;
+    // record of the shared cache of the handle, held while it is current
+    std::shared_ptr<hipo::record> cachedRecord;
+    hipo::record*                 recordInUse = &cursorRecord;
+    // structures to decompress from columnar records, all if empty
+    std::vector<int> structuresToRead;
+
+    int  currentRecord = -1;
+    long currentEvent  = -1;
+
+    bool loadRecord(int recordNumber);
+
+  public:
+    fileCursor(std::shared_ptr<const fileHandle> h) : handle(h) {}
+    ~fileCursor() {}
+
+    void setBanks(const std::vector<std::string>& names);
+    void setDecompressionThreads(int n) { cursorRecord.setDecompressionThreads(n); }
+    bool hasNext() { return currentEvent + 1 < handle->numEvents(); }
+    bool next(hipo::event& dataevent);
+    bool gotoEvent(long eventNumber);
+    bool readEvent(long eventNumber, hipo::event& dataevent);
+    void read(hipo::event& dataevent);
+    long getEventNumber() { return currentEvent; }
+    long numEvents() { return handle->numEvents(); }
+  };
+} // namespace hipo
+#endif /* HIPO_FILEHANDLE_H */
@@ -0,0 +1,83 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   prefetcher.h
+ *
+ * Background read-ahead of records. A worker thread reads and
+ * decompresses the records following the one being processed into a
+ * ring of record buffers, so disk I/O and LZ4 decompression overlap
+ * with the analysis of the current record.
+ */
+
+#ifndef HIPO_PREFETCHER_H
+#define HIPO_PREFETCHER_H
+
+#include "record.h"
+#include "uring.h"
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hipo {
+
+  class prefetcher {
+  private:
+    std::vector<std::unique_ptr<hipo::record>> ring;
+    std::vector<long>                          positions;
+    std::vector<long>                          lengths;
+    // 1 if the record in the slot was read, 0 if the read failed
+    std::vector<char> ringStatus;
+
+    std::string   fileName;
+    std::ifstream inputStream;
+    const char*   mappedBuffer;
+    long          mappedSize;
+    // descriptor of the reader for pread() or O_DIRECT reads, if >= 0
+    int  fileDescriptor;
+    bool directIO;
+
+    // batched io_uring reads of the raw records, one buffer per ring slot
+    hipo::uringReader                uring;
+    std::vector<hipo::alignedBuffer> ringBuffers;
+
+    std::thread             worker;
+    std::mutex              ringMutex;
+    std::condition_variable ringCondition;
+
+    // first record not yet read by the worker, record held by the consumer
+    int  nextToRead;
+    int  currentRecord;
+    bool stopRequested;
+
+    void run();
+    bool readRecord(hipo::record& rec, int recordNumber);
+    void readBatch(int first, int last);
+    void start(int firstRecord);
+    void stop();
+
+  public:
+    prefetcher();
+    ~prefetcher();
+
+    void          open(const char* filename, const char* buffer, long size,
+                       const std::vector<long>& recordPositions,
+                       const std::vector<long>& recordLengths, int depth,
+                       std::shared_ptr<hipo::codec> dictionaryCodec = nullptr,
+                       const std::vector<int>&      structures      = std::vector<int>(),
+                       int                          threads         = 1,
+                       bool                         asyncIO         = false,
+                       int                          descriptor      = -1,
+                       bool                         direct          = false);
+    void          close();
+    bool          isOpen() { return ring.size() > 0; }
+    hipo::record* getRecord(int recordNumber);
+  };
+} // namespace hipo
+#endif /* HIPO_PREFETCHER_H */
@@ -0,0 +1,66 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   prefilter.h
+ *
+ * Column prefilters applied to the banks of a record before compression.
+ * Float and double columns are byte-shuffled (all first bytes of the
+ * column, then all second bytes, ...), so that exponents and sign bytes
+ * end up next to each other. Selected integer columns (e.g. index,
+ * pindex, sector) are delta-encoded.
+ *
+ * A filtered record has bit 16 set in the record header bitInfo and
+ * carries a layout table in the record user header, which describes the
+ * columns of every filtered bank, so the record can be decoded without
+ * the dictionary. Layout table entries :
+ *
+ *    group (16 bits) | item (8 bits) | number of columns (8 bits)
+ *    one byte per column : filter (upper 4 bits) | type (lower 4 bits)
+ */
+
+#ifndef HIPO_PREFILTER_H
+#define HIPO_PREFILTER_H
+
+#include "dictionary.h"
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace hipo {
+
+  // prefilter flags for writer::setPrefilter
+  enum prefilterFlags_t { kPrefilterShuffle = 1, kPrefilterDelta = 2 };
+
+  class prefilter {
+  private:
+    // column codes of each bank, keyed by (group << 8) | item
+    std::map<int, std::vector<uint8_t>> bankColumns;
+    std::vector<char>                   scratch;
+
+    static int  getTypeSize(int type);
+    static bool getBank(const char* structure, int& key, int& length);
+    void        shuffle(char* data, int rows, int size);
+    void        unshuffle(char* data, int rows, int size);
+    static void deltaEncode(char* data, int rows, int size);
+    static void deltaDecode(char* data, int rows, int size);
+    void        apply(char* events, int size, bool forward, std::map<int, bool>& used);
+
+  public:
+    static const int recordBit = 0x00010000;
+
+    prefilter() {}
+    ~prefilter() {}
+
+    void setFilters(hipo::dictionary& dict, int flags,
+                    const std::vector<std::string>& deltaColumns);
+    bool isEmpty() const { return bankColumns.size() == 0; }
+
+    void encode(char* events, int size, std::vector<char>& layout);
+    void decode(char* events, int size, const char* layout, int layoutSize);
+  };
+} // namespace hipo
+#endif /* HIPO_PREFILTER_H */
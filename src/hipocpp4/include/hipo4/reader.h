@@ -77,14 +77,19 @@
 #define LITTLE_ENDIAN 1
 #endif
 
+#include "runindex.h"
+#include "prefetcher.h"
 #include "record.h"
+#include "recordcache.h"
 #include "utils.h"
+#include <atomic>
 #include <climits>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <stdio.h>
 #include <stdlib.h>
+#include <thread>
 #include <vector>
 
 namespace hipo {
@@ -110,7 +115,20 @@ namespace hipo {
     int  recordEntries;
     long userWordOne;
     long userWordTwo;
+    // minimum and maximum of every statistic (see writer::addStatistics)
+    std::vector<double> statistics;
   } recordInfo_t;
+
+  // range of a record statistic, records outside of it are skipped
+  typedef struct {
+    std::string bank;
+    std::string column;
+    double      min;
+    double      max;
+  } recordFilter_t;
+  // use of the page cache by the reader, see reader::setPageCachePolicy()
+  enum pageCachePolicy_t { kPageCacheDefault = 0, kPageCacheStreaming = 1, kPageCacheDirect = 2 };
+
   /**
    * READER index class is used to construct entire events
    * sequence from all records, and provides ability to canAdvance
@@ -120,12 +138,15 @@ namespace hipo {
    */
   class readerIndex {
   private:
-    std::vector<int>  recordEvents;
+    // number of events before each record, events are counted with long
+    std::vector<long> recordEvents;
     std::vector<long> recordPosition;
+    // length of the records (header and data) in bytes, from the file index
+    std::vector<long> recordLength;
 
-    int currentRecord;
-    int currentEvent;
-    int currentRecordEvent;
+    int  currentRecord;
+    long currentEvent;
+    int  currentRecordEvent;
 
   public:
     readerIndex(){
@@ -135,14 +156,20 @@ namespace hipo {
 
     bool canAdvance();
     bool advance();
+    bool gotoEvent(long eventNumber);
 
-    int  getEventNumber() { return currentEvent; }
+    long getEventNumber() { return currentEvent; }
     int  getRecordNumber() { return currentRecord; }
     int  getRecordEventNumber() { return currentRecordEvent; }
-    int  getMaxEvents();
+    long getMaxEvents() const;
+    int  getMaxRecords() const { return recordPosition.size(); }
     void addSize(int size);
     void addPosition(long position) { recordPosition.push_back(position); }
-    long getPosition(int index) { return recordPosition[index]; }
+    long getPosition(int index) const { return recordPosition[index]; }
+    void addLength(long length) { recordLength.push_back(length); }
+    long getLength(int index) const { return recordLength[index]; }
+    long getFirstEvent(int index) const { return recordEvents[index]; }
+    int  findRecord(long eventNumber) const;
     void rewind() {
       currentRecord      = -1;
       currentEvent       = -1;
@@ -151,6 +178,7 @@ namespace hipo {
     void clear() {
       recordEvents.clear();
       recordPosition.clear();
+      recordLength.clear();
     }
     void reset() {
       currentRecord      = 0;
@@ -159,19 +187,78 @@ namespace hipo {
     }
   };
 
+  class chain;
+
   class reader {
   private:
     fileHeader_t  header;
     hipo::utils   hipoutils;
     std::ifstream inputStream;
     long          inputStreamSize;
+    std::string   inputFileName;
 
     hipo::record      inputRecord;
     hipo::readerIndex readerEventIndex;
     std::vector<long> tagsToRead;
+    // ranges of record statistics, see addFilter()
+    std::vector<hipo::recordFilter_t> recordFilters;
+
+    // memory mapped file, used when memory mapping is enabled
+    bool        useMemoryMap = false;
+    const char* mappedBuffer = NULL;
+
+    // background read-ahead of records, used when prefetch depth is > 0
+    int              prefetchDepth = 0;
+    hipo::prefetcher recordPrefetcher;
+    hipo::record*    currentRecord = &inputRecord;
+    // number of the record currentRecord holds, -1 if none (see resetRecords),
+    // and whether reading it failed
+    int  loadedRecord       = -1;
+    bool loadedRecordFailed = false;
+    // number of records that could not be read, see getFailedRecords()
+    std::atomic<long> failedRecords{0};
+    // batched io_uring reads in the read-ahead, see setAsyncIO()
+    bool useAsyncIO = false;
 
+    // descriptor reading records with the page cache policy, see
+    // setPageCachePolicy(), and end of the pages already dropped
+    int  pageCachePolicy     = kPageCacheDefault;
+    int  pageCacheDescriptor = -1;
+    long pageCacheDropped    = 0;
+
+    // decompressed records kept for out of order access, see setCacheSize()
+    hipo::recordCache             recordsCache;
+    std::shared_ptr<hipo::record> cachedRecord;
+
+    // run/event lookup index (file.hipo.idx), loaded on first use
+    hipo::runIndex lookupIndex;
+    bool           lookupIndexLoaded = false;
+    hipo::record   lookupRecord;
+    long           lookupRecordPosition = -1;
+
+    // codec with the LZ4 dictionary of the file (user header), if any
+    std::shared_ptr<hipo::codec> dictionaryCodec;
+    // structures to decompress from columnar records, all if empty
+    std::vector<int> structuresToRead;
+    // threads decompressing the blocks of block compressed records
+    int decompressionThreads = 1;
+
+    void openFile(const char* filename);
     void readHeader();
     void readIndex();
+    void readRecordStatistics(hipo::event& indexEvent, std::vector<bool>& accepted);
+    void readCompressionDictionary();
+    bool readRecord(hipo::record& rec, long position);
+    bool loadRecord(int recordNumber);
+    bool loadCurrentRecord();
+    void resetRecords();
+
+    std::shared_ptr<hipo::record> getCachedRecord(long position);
+    void mapFile(const char* filename);
+    void unmapFile();
+    void openPageCacheDescriptor();
+    void closePageCacheDescriptor();
+    void advisePageCache(int recordNumber);
 
   public:
     reader();
@@ -183,13 +270,109 @@ namespace hipo {
     hipo::dictionary* dictionary();
     void              open(const char* filename);
     void              open(std::string filename) { open(filename.c_str()); };
+    void              open(const char* filename, const hipo::fileHeader_t& fileHeader,
+                           const hipo::readerIndex& index, std::shared_ptr<hipo::codec> codec);
     void              setTags(int tag) { tagsToRead.push_back(tag); }
+    void              addFilter(const std::string& bank, const std::string& column, double min,
+                                double max);
+    void              setMemoryMapped(bool flag) { useMemoryMap = flag; }
+    bool              isMemoryMapped() const { return mappedBuffer != NULL; }
+    void              setPrefetch(int depth);
+    void              setAsyncIO(bool flag);
+    void              setPageCachePolicy(int policy);
+    void              setBanks(const std::vector<std::string>& names);
+    void              setDecompressionThreads(int n);
+    void              setCacheSize(long bytes);
+    long              getCacheHits() { return recordsCache.getHits(); }
+    long              getCacheMisses() { return recordsCache.getMisses(); }
+    long              getFailedRecords() const { return failedRecords; }
     bool              hasNext();
     bool              next();
     long              numEvents() { return readerEventIndex.getMaxEvents(); }
     bool              next(hipo::event& dataevent);
     void              read(hipo::event& dataevent);
+    void              read(hipo::eventView& dataevent);
+    bool              gotoEvent(long eventNumber);
+    bool              readEvent(long eventNumber, hipo::event& dataevent);
+    long              getEventNumber() { return readerEventIndex.getEventNumber(); }
     void              printWarning();
+    bool              findEvent(int run, int event, hipo::event& dataevent);
+
+    const hipo::fileHeader_t&    getHeader() const { return header; }
+    const hipo::readerIndex&     getIndex() const { return readerEventIndex; }
+    std::shared_ptr<hipo::codec> getDictionaryCodec() const { return dictionaryCodec; }
+    long                         getFileSize() const { return inputStreamSize; }
+    const std::string&           getFileName() const { return inputFileName; }
+
+    bool readRecord(hipo::record& rec, std::ifstream& stream, long position,
+                    bool selected = true) const;
+
+    template <typename T, typename Process, typename Reduce>
+    T forEachParallel(int nthreads, T init, Process process, Reduce reduce);
   };
+
+  /**
+   * Processes all events of the file on nthreads threads (0 = number of
+   * cores). Whole records are handed out to the threads, each thread reads
+   * and decompresses them with its own record and event, and calls
+   * process(hipo::event&, T&) for every event with its own copy of init.
+   * Banks used in process() should therefore be members of T. When all
+   * records are processed the per-thread results are combined with
+   * reduce(T& total, T& partial) and returned, init should be the
+   * identity state of the reduction. The order in which events are
+   * processed is not defined and the current position of the reader is
+   * not changed. Records that can not be read are skipped with a warning
+   * and counted by getFailedRecords().
+   */
+  template <typename T, typename Process, typename Reduce>
+  T reader::forEachParallel(int nthreads, T init, Process process, Reduce reduce) {
+    if (nthreads <= 0)
+      nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0)
+      nthreads = 1;
+
+    int              nrecords = readerEventIndex.getMaxRecords();
+    std::atomic<int> nextRecord(0);
+    std::vector<T>   results(nthreads, init);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < nthreads; t++) {
+      workers.push_back(std::thread([this, t, nrecords, &nextRecord, &results, &process] {
+        std::ifstream stream;
+        if (mappedBuffer == NULL) {
+          stream.open(inputFileName.c_str(), std::ios::binary);
+          if (stream.is_open() == false)
+            std::cerr << "---> error : can not open file " << inputFileName << std::endl;
+        }
+        T            local = results[t];
+        hipo::record rec;
+        hipo::event  event;
+        int          recordNumber;
+        while ((recordNumber = nextRecord++) < nrecords) {
+          long position = readerEventIndex.getPosition(recordNumber);
+          if ((mappedBuffer == NULL && stream.is_open() == false) ||
+              readRecord(rec, stream, position) == false) {
+            std::cerr << "[WARNING] record " << recordNumber << " at position " << position
+                      << " can not be read" << std::endl;
+            failedRecords++;
+            continue;
+          }
+          int nevents = rec.getEventCount();
+          for (int i = 0; i < nevents; i++) {
+            rec.readHipoEvent(event, i);
+            process(event, local);
+          }
+        }
+        results[t] = std::move(local);
+      }));
+    }
+    for (auto& worker : workers)
+      worker.join();
+
+    T total = std::move(results[0]);
+    for (int t = 1; t < nthreads; t++)
+      reduce(total, results[t]);
+    return total;
+  }
 } // namespace hipo
 #endif /* HIPOFILE_H */
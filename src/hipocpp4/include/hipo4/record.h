@@ -22,7 +22,9 @@
 #include <string>
 #include <vector>
 
+#include "codec.h"
 #include "event.h"
+#include "prefilter.h"
 #include "utils.h"
 
 namespace hipo {
@@ -70,8 +72,37 @@ namespace hipo {
     int             getDataOffset() { return data_offset; }
   };
 
+  /**
+   * Columnar records (bit 17 of the record header bitInfo) keep the data
+   * of each structure (group,item) of all events together in a chunk that
+   * is compressed on its own, so readers can decompress only the banks
+   * they use. The record itself is not compressed, it contains the event
+   * index array, the chunk table as user header and the chunks :
+   *
+   *    chunk table : number of chunks, then for every chunk
+   *                  key ((group << 8) | item), compression type,
+   *                  compressed length, uncompressed length
+   *    chunk       : length of the structure in every event (0 if the
+   *                  event does not have it), then the structures
+   *
+   * The first chunk (key -1) has the 16 byte headers of all events. When
+   * read, the events are put back together from the selected chunks.
+   *
+   * Block compressed records (bit 18) split the record data into blocks
+   * that are compressed on their own, so a large record can be
+   * decompressed by several threads. The compressed data starts with the
+   * block table : number of blocks, then for every block the compression
+   * type, compressed length and uncompressed length.
+   */
   class record {
 
+  public:
+    static const int columnarBit       = 0x00020000;
+    static const int columnarHeaderKey = -1;
+    static const int blockBit          = 0x00040000;
+    // offset, length and buffer alignment of O_DIRECT reads
+    static const int directAlignment = 4096;
+
   private:
     // std::vector< std::vector<char> > eventBuffer;
     std::vector<char> recordHeaderBuffer;
@@ -79,10 +110,41 @@ namespace hipo {
 
     std::vector<char> recordBuffer;
     std::vector<char> recordCompressedBuffer;
+    std::vector<int>  recordEventPositions;
+    // points to the uncompressed record data, which is either the record
+    // buffer, the compressed buffer (no compression) or a memory mapped file
+    const char* recordData = NULL;
+    // reverses the column prefilters of filtered records
+    hipo::prefilter recordPrefilter;
+    // codec with the dictionary of the file, for records of type lz4dict
+    std::shared_ptr<hipo::codec> dictionaryCodec;
+    // structure keys to read from columnar records, all if empty
+    std::vector<int>  structureFilter;
+    std::vector<char> columnBuffer;
+    // threads decompressing the blocks of block compressed records
+    int decompressionThreads = 1;
+    // block aligned buffer for O_DIRECT reads, see readRecordDirect()
+    std::unique_ptr<char, void (*)(void*)> directBuffer{NULL, free};
+    long                                   directBufferSize = 0;
 
     char* getUncompressed(const char* data, int dataLength, int dataLengthUncompressed);
     int   getUncompressed(const char* data, char* dest, int dataLength, int dataLengthUncompressed);
     void  showBuffer(const char* data, int wrapping, int maxsize);
+    void  readRecordHeader(const char* buffer);
+    void  readRecordIndex();
+    bool  decodeRecord(const char* dataBuffer, int dataLength);
+    bool  failRecord();
+    void  removePrefilter();
+    bool  readColumns();
+    int   getUncompressedBlocks(const char* data, char* dest, int dataLength,
+                                int dataLengthUncompressed);
+    int   getUncompressedTruncated(const char* data, char* dest, int dataLength,
+                                   int dataLengthUncompressed);
+    int   getDataLength();
+    int   getDataOffset();
+
+    const codec* getCodec(int compressionType);
+    long         readAligned(int fd, long offset, long length);
 
   public:
     record();
@@ -91,10 +153,18 @@ namespace hipo {
     void readRecord(std::ifstream& stream, long position, int dataOffset);
     void readRecord__(std::ifstream& stream, long position, long recordLength);
     bool readRecord(std::ifstream& stream, long position, int dataOffset, long inputSize);
+    bool readRecord(const char* buffer, long position, long bufferSize);
+    bool readRecord(int fd, long position, long inputSize);
+    bool readRecordDirect(int fd, long position, long inputSize);
+    void setDictionaryCodec(std::shared_ptr<hipo::codec> c) { dictionaryCodec = c; }
+    void setStructureFilter(const std::vector<int>& keys) { structureFilter = keys; }
+    void setDecompressionThreads(int n) { decompressionThreads = (n > 0) ? n : 1; }
     int  getEventCount();
     int  getRecordSizeCompressed();
+    long getMemorySize();
     void readEvent(std::vector<char>& vec, int index);
     void readHipoEvent(hipo::event& event, int index);
+    void readHipoEvent(hipo::eventView& event, int index);
     void getData(hipo::data& data, int index);
   };
 } // namespace hipo
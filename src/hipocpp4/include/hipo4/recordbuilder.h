@@ -16,13 +16,16 @@
 
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
 #include <vector>
 
+#include "codec.h"
 #include "event.h"
+#include "prefilter.h"
 #include "utils.h"
 
 namespace hipo {
@@ -41,8 +44,37 @@ namespace hipo {
     int bufferIndexEntries;
     int bufferEventsPosition;
 
-    int compressRecord(int src_size);
-    int getRecordLengthRounding(int bufferSize);
+    std::shared_ptr<hipo::codec> recordCodec;
+    double                       minCompressionGain;
+
+    // column prefilter, the layout table goes to the record user header
+    hipo::prefilter   recordPrefilter;
+    bool              usePrefilter = false;
+    bool              bufferEventsFiltered;
+    std::vector<char> bufferLayout;
+
+    // columnar layout, one chunk per structure (see record.h)
+    bool                           useColumnar = false;
+    std::map<int, int>             columnIndex;
+    std::vector<int>               columnKeys;
+    std::vector<std::vector<int>>  columnLengths;
+    std::vector<std::vector<char>> columnData;
+    std::vector<char>              columnScratch;
+
+    // block compression, records larger than the block size are split
+    // into blocks compressed one by one (see record.h)
+    int blockSize = 0;
+
+    // statistics of the events in the record, filled by the writer
+    std::vector<double> recordStatistics;
+    // record tag (user word one), kept across reset()
+    long userWordOne = 0;
+
+    int  compressRecord(int src_size);
+    int  compressBlocks(int src_size);
+    int  getRecordLengthRounding(int bufferSize);
+    void buildColumnar();
+    int  addColumnChunk(int key, int nevents);
 
   public:
     recordbuilder(int maxEvents, int maxLength);
@@ -59,6 +91,18 @@ namespace hipo {
     std::vector<char>& getRecordBuffer() { return bufferRecord; };
     void               reset();
     void               build();
+
+    void setCodec(std::shared_ptr<hipo::codec> c) { recordCodec = c; }
+    void setMinCompressionGain(double gain) { minCompressionGain = gain; }
+    void setPrefilter(const hipo::prefilter& p) {
+      recordPrefilter = p;
+      usePrefilter    = !p.isEmpty();
+    }
+    void setColumnar(bool flag) { useColumnar = flag; }
+    void setBlockSize(int size) { blockSize = size; }
+    std::vector<double>& getStatistics() { return recordStatistics; }
+    void                 setUserWordOne(long word) { userWordOne = word; }
+    int  getCompressionType() { return (*reinterpret_cast<int*>(&bufferRecord[36]) >> 28) & 0xF; }
   };
 } // namespace hipo
 #endif /* HIPORECORD_H */
@@ -0,0 +1,69 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   recordcache.h
+ *
+ * Memory bounded LRU cache of decompressed records, keyed by the
+ * position of the record in the file. Used by the reader and shared by
+ * the cursors of a fileHandle when events are accessed out of order
+ * (event mixing, sorted event lists, joins of friend files), so records
+ * visited again are not read and decompressed again. Thread safe.
+ */
+
+#ifndef HIPO_RECORDCACHE_H
+#define HIPO_RECORDCACHE_H
+
+#include "record.h"
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace hipo {
+
+  class recordCache {
+  private:
+    struct cacheEntry_t {
+      long                          position;
+      long                          size;
+      std::shared_ptr<hipo::record> rec;
+    };
+
+    // most recently used record first
+    std::list<cacheEntry_t>                           entries;
+    std::map<long, std::list<cacheEntry_t>::iterator> lookup;
+    // last evicted record, its buffers are reused for the next record
+    std::shared_ptr<hipo::record> spare;
+    std::mutex                    cacheMutex;
+
+    long maxSize   = 0;
+    long cacheSize = 0;
+    long hits      = 0;
+    long misses    = 0;
+
+    void evict();
+
+  public:
+    recordCache() {}
+    ~recordCache() {}
+
+    void setMaxSize(long bytes);
+    long getMaxSize() { return maxSize; }
+    bool isEnabled() { return maxSize > 0; }
+    void clear();
+
+    std::shared_ptr<hipo::record> find(long position);
+    std::shared_ptr<hipo::record> create();
+    void                          insert(long position, std::shared_ptr<hipo::record> rec);
+
+    long getHits() { return hits; }
+    long getMisses() { return misses; }
+    long getSize() { return cacheSize; }
+    int  getEntries() { return entries.size(); }
+    void resetCounters();
+  };
+} // namespace hipo
+#endif /* HIPO_RECORDCACHE_H */
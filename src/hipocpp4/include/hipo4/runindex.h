@@ -0,0 +1,61 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   runindex.h
+ *
+ * Run and event number lookup index, kept in a file next to the data
+ * file (file.hipo.idx). The index maps (run, event) from the RUN::config
+ * bank to the position of the record in the file and the event number in
+ * the record, sorted by run and event. Index file layout (little endian) :
+ *
+ *    magic "HIDX" (int), version (int), size of the data file (long),
+ *    number of entries (long), then the entries (see runIndexEntry_t)
+ *
+ * The size of the data file is used to detect indices that are out of
+ * date.
+ */
+
+#ifndef HIPO_RUNINDEX_H
+#define HIPO_RUNINDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace hipo {
+
+  class reader;
+
+  typedef struct {
+    int  run;
+    int  event;
+    long position; // position of the record in the file
+    int  index;    // event number in the record
+    int  reserved;
+  } runIndexEntry_t;
+
+  class runIndex {
+  private:
+    std::vector<runIndexEntry_t> indexEntries;
+    long                         indexFileSize = 0;
+
+  public:
+    runIndex() {}
+    ~runIndex() {}
+
+    bool build(hipo::reader& r, int nthreads = 0);
+    bool write(const std::string& filename);
+    bool read(const std::string& filename);
+    bool find(int run, int event, long& position, int& index);
+    void clear();
+
+    int  getEntries() { return indexEntries.size(); }
+    long getFileSize() { return indexFileSize; }
+
+    static std::string getIndexName(const std::string& filename) { return filename + ".idx"; }
+  };
+} // namespace hipo
+#endif /* HIPO_RUNINDEX_H */
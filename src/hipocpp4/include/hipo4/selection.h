@@ -0,0 +1,72 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   selection.h
+ *
+ * Row selection over bank columns. A selection is a list of conditions
+ * on columns which are combined with AND, bank::select evaluates each
+ * condition over the whole column at once. The kernels of int8, int16,
+ * int32 and float columns use AVX2 or SSE4.1 when the CPU supports it
+ * (checked at runtime) and a scalar loop otherwise.
+ */
+
+#ifndef HIPO_SELECTION_H
+#define HIPO_SELECTION_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace hipo {
+
+  typedef struct {
+    std::string name;
+    double      low;      // inclusive
+    double      high;     // exclusive
+    bool        absolute; // compare the absolute value
+    bool        invert;   // select rows outside of the range
+  } selectionCondition_t;
+
+  class selection {
+  private:
+    std::vector<selectionCondition_t> conditions;
+
+  public:
+    selection() {}
+    ~selection() {}
+
+    selection& range(const char* name, double low, double high);
+    selection& absRange(const char* name, double low, double high);
+    selection& equal(const char* name, double value);
+    selection& notEqual(const char* name, double value);
+    selection& less(const char* name, double value);
+    selection& lessEqual(const char* name, double value);
+    selection& greater(const char* name, double value);
+    selection& greaterEqual(const char* name, double value);
+
+    int                         getConditions() const { return conditions.size(); }
+    const selectionCondition_t& getCondition(int index) const { return conditions[index]; }
+    void                        clear() { conditions.clear(); }
+  };
+
+  /**
+   * Column kernels: for each row, mask[row] is cleared unless
+   * low <= value < high (|value| if absolute, outside if invert).
+   */
+  void selectColumn(const int8_t* values, int rows, const selectionCondition_t& c, uint8_t* mask);
+  void selectColumn(const int16_t* values, int rows, const selectionCondition_t& c, uint8_t* mask);
+  void selectColumn(const int32_t* values, int rows, const selectionCondition_t& c, uint8_t* mask);
+  void selectColumn(const float* values, int rows, const selectionCondition_t& c, uint8_t* mask);
+  void selectColumn(const double* values, int rows, const selectionCondition_t& c, uint8_t* mask);
+  void selectColumn(const int64_t* values, int rows, const selectionCondition_t& c, uint8_t* mask);
+
+  enum selectKernel_t { kSelectScalar = 0, kSelectSSE41 = 1, kSelectAVX2 = 2 };
+
+  int  getSelectKernel();
+  int  setSelectKernel(int kernel);
+  bool selectHasAVX2();
+} // namespace hipo
+#endif /* HIPO_SELECTION_H */
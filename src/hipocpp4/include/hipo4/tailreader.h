@@ -0,0 +1,78 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   tailreader.h
+ *
+ * Reads events of a HIPO file that is still being written (online
+ * monitoring). The reader requires the trailer index, which is only
+ * written when the file is closed. The tail reader instead walks the
+ * record headers from the first record, returns the events of every
+ * complete record and waits for the file to grow (inotify on Linux,
+ * polling otherwise) when it reaches an incomplete record. Reading
+ * stops at the trailer index record of the closed file.
+ *
+ *   hipo::tailReader tail;
+ *   tail.open("online.hipo");
+ *   tail.setTimeout(60); // give up after a minute without new records
+ *   hipo::event event;
+ *   while (tail.next(event)) { ... }
+ */
+
+#ifndef HIPO_TAILREADER_H
+#define HIPO_TAILREADER_H
+
+#include "dictionary.h"
+#include "event.h"
+#include "record.h"
+#include <memory>
+#include <string>
+
+namespace hipo {
+
+  class tailReader {
+  private:
+    std::string fileName;
+    int         fileDescriptor   = -1;
+    int         notifyDescriptor = -1;
+
+    long headerLength    = 0;
+    long firstRecord     = 0;
+    long trailerPosition = 0;
+    long nextPosition    = 0;
+    bool fileFinished    = false;
+
+    hipo::record inputRecord;
+    int          recordEvents = 0;
+    int          recordEvent  = 0;
+    // complete records that could not be read
+    long failedRecords = 0;
+    // codec with the LZ4 dictionary of the file (user header), if any
+    std::shared_ptr<hipo::codec> dictionaryCodec;
+
+    int pollInterval = 500; // ms
+    int waitTimeout  = -1;  // s, wait forever if < 0
+
+    long getFileSize();
+    bool readFileHeader();
+    bool readNextRecord();
+    void waitForData();
+
+  public:
+    tailReader() {}
+    ~tailReader() { close(); }
+
+    bool open(const char* filename);
+    void close();
+    void setPollInterval(int ms) { pollInterval = (ms > 0) ? ms : 1; }
+    void setTimeout(int seconds) { waitTimeout = seconds; }
+    bool next(hipo::event& dataevent);
+    bool isFinished() { return fileFinished; }
+    long getPosition() { return nextPosition; }
+    long getFailedRecords() { return failedRecords; }
+    void readDictionary(hipo::dictionary& dict);
+  };
+} // namespace hipo
+#endif /* HIPO_TAILREADER_H */
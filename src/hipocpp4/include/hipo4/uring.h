@@ -0,0 +1,83 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+/*
+ * File:   uring.h
+ *
+ * Batched asynchronous reading of records with Linux io_uring. All
+ * reads of a batch are submitted at once, so the device sees a deep
+ * queue instead of one blocking read at a time. Uses the kernel
+ * interface directly (no liburing). Compiled in with -D__URING__
+ * (cmake -DUSE_IO_URING=ON), otherwise isAvailable() returns false
+ * and callers use their regular read path.
+ */
+
+#ifndef HIPO_URING_H
+#define HIPO_URING_H
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hipo {
+
+  /**
+   * Block aligned buffer reused for the records read in batches, grown
+   * when a larger record comes and never shrunk. The content is not kept
+   * when it grows.
+   */
+  class alignedBuffer {
+  private:
+    std::unique_ptr<char, void (*)(void*)> bufferData{NULL, free};
+    long                                   bufferSize = 0;
+
+  public:
+    static const int alignment = 4096;
+
+    char* data() { return bufferData.get(); }
+    long  size() const { return bufferSize; }
+    bool  reserve(long size);
+  };
+
+  class uringReader {
+  private:
+    int      ringDescriptor = -1;
+    int      fileDescriptor = -1;
+    long     fileSize       = 0;
+    unsigned queueDepth     = 0;
+
+    // submission and completion rings shared with the kernel
+    void*     sqRing     = NULL;
+    void*     cqRing     = NULL;
+    void*     sqEntries  = NULL;
+    size_t    sqRingSize = 0;
+    size_t    cqRingSize = 0;
+    size_t    sqeSize    = 0;
+    unsigned* sqTail     = NULL;
+    unsigned* sqMask     = NULL;
+    unsigned* sqArray    = NULL;
+    unsigned* cqHead     = NULL;
+    unsigned* cqTail     = NULL;
+    unsigned* cqMask     = NULL;
+    void*     cqEntries  = NULL;
+
+    bool read(const std::vector<long>& offsets, const std::vector<long>& lengths,
+              std::vector<char*>& destinations);
+
+  public:
+    uringReader() {}
+    ~uringReader() { close(); }
+
+    static bool isAvailable();
+
+    bool open(const char* filename, int depth);
+    void close();
+    bool isOpen() { return ringDescriptor >= 0; }
+    bool readRecords(const std::vector<long>& positions, const std::vector<long>& lengths,
+                     std::vector<hipo::alignedBuffer*>& buffers);
+  };
+} // namespace hipo
+#endif /* HIPO_URING_H */
@@ -80,11 +80,16 @@
 #include "reader.h"
 #include "recordbuilder.h"
 #include <climits>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdio.h>
 #include <stdlib.h>
+#include <thread>
 #include <vector>
 
 namespace hipo {
@@ -114,20 +119,78 @@ namespace hipo {
   class writer {
 
   private:
-    std::ofstream                   outputStream;
-    hipo::recordbuilder             recordBuilder;
-    hipo::dictionary                writerDictionary;
-    std::vector<hipo::recordInfo_t> writerRecordInfo;
+    std::ofstream                                     outputStream;
+    std::vector<std::unique_ptr<hipo::recordbuilder>> writerBuilders;
+    // builder being filled for every tag (user word one of the records)
+    std::map<long, hipo::recordbuilder*>              tagBuilders;
+    hipo::dictionary                                  writerDictionary;
+    std::vector<hipo::recordInfo_t>                   writerRecordInfo;
+    std::shared_ptr<hipo::codec>                      writerCodec;
+    double                                            writerMinGain = 0.0;
+    int                                               writerPrefilter = 0;
+    std::vector<std::string>                          writerDeltaColumns;
+    std::vector<char>                                 writerCompressionDictionary;
+    bool                                              writerColumnar = false;
+    int                                               writerBlockSize = 0;
+    hipo::prefilter                                   writerFilter;
+
+    // per record minimum and maximum of bank columns (or of the number of
+    // rows, for an empty column name), stored with the trailer index
+    std::vector<std::pair<std::string, std::string>> writerStatistics;
+    std::vector<std::unique_ptr<hipo::bank>>         statisticsBanks;
+    std::vector<int>                                 statisticsItems;
+    std::vector<double>                              eventStatistics;
+
+    // background compression: full builders are queued with a sequence
+    // number, compressed by the worker threads and written in sequence
+    // order by whichever worker holds the next record to be written.
+    int                                               writerThreads = 0;
+    std::vector<std::thread>                          writerWorkers;
+    std::deque<hipo::recordbuilder*>                  freeBuilders;
+    std::deque<std::pair<long, hipo::recordbuilder*>> buildQueue;
+    std::map<long, hipo::recordbuilder*>              builtRecords;
+    std::mutex                                        writerMutex;
+    std::condition_variable                           writerCondition;
+    long                                              nextSubmit = 0;
+    long                                              nextWrite  = 0;
+    bool                                              writerBusy = false;
+    bool                                              writerStop = false;
 
     void writeIndexTable();
+    void writeBuiltRecord(recordbuilder& builder);
+    void submitRecord(long tag);
+    void configureBuilder(hipo::recordbuilder& builder);
+    hipo::recordbuilder*& getBuilder(long tag);
+    void workerLoop();
+    void stopWorkers();
+    void initStatistics();
+    void fillStatistics(hipo::event& hevent);
 
   public:
-    writer(){};
+    writer();
     writer(const char* filename);
     writer(const std::string& filename);
     virtual ~writer() { writer::close(); };
 
+    // number of threads compressing and writing records in the background,
+    // 0 writes inline in addEvent. Set before open().
+    void              setCompressionThreads(int nthreads) { writerThreads = nthreads; }
+    void              setBackground(bool flag) { writerThreads = flag ? 1 : 0; }
+    void              setCompression(int type, int level = -1);
+    void              setCompression(const std::string& name, int level = -1);
+    void              setMinCompressionGain(double gain) { writerMinGain = gain; }
+    void              setPrefilter(int flags);
+    void              setPrefilter(int flags, const std::vector<std::string>& deltaColumns);
+    void              setColumnar(bool flag) { writerColumnar = flag; }
+    void              setBlockSize(int size);
+    void              setCompressionDictionary(const std::vector<char>& dict,
+                                               int acceleration = -1);
+    void              addStatistics(const std::string& bank, const std::string& column = "");
+
+    static std::vector<char> buildCompressionDictionary(std::vector<hipo::event>& samples,
+                                                        int maxSize = 65536);
     void              addEvent(hipo::event& hevent);
+    void              addEvent(hipo::event& hevent, long tag);
     void              writeRecord(recordbuilder& builder);
     void              open(const std::string& filename);
     void              open(const char* filename);
@@ -5,6 +5,7 @@
  */
 #include "hipo4/bank.h"
 #include "hipo4/utils.h"
+#include <algorithm>
 #include <cmath>
 
 namespace hipo {
@@ -81,7 +82,13 @@ namespace hipo {
     std::memcpy(&structureBuffer[8], &str[0], strLen);
   }
 
-  const char* structure::getAddress() { return structureAddress; }
+  /**
+   * points the structure to external memory without copying it, the
+   * memory is not owned by the structure.
+   */
+  void structure::setAddress(const char* address) {
+    structureAddress = const_cast<char*>(address);
+  }
   //====================================================================
   // END of structure class
   //====================================================================
@@ -97,6 +104,70 @@ namespace hipo {
     bankRows = getSize() / bankSchema.getRowLength();
   }
 
+  /**
+   * Evaluates the selection on the bank, one column at a time. On return
+   * mask has one entry per row, 1 for rows passing all conditions. Returns
+   * the number of selected rows. A condition on a column that is not in
+   * the bank selects nothing.
+   */
+  int bank::select(const hipo::selection& sel, std::vector<uint8_t>& mask) {
+    int nrows = (bankRows > 0) ? bankRows : 0;
+    mask.assign(nrows, 1);
+    if (nrows == 0)
+      return 0;
+    for (int c = 0; c < sel.getConditions(); c++) {
+      const selectionCondition_t& condition = sel.getCondition(c);
+      if (bankSchema.hasEntry(condition.name.c_str()) == false) {
+        std::cerr << "---> error : bank [" << bankSchema.getName() << "] has no column ["
+                  << condition.name << "]" << std::endl;
+        std::fill(mask.begin(), mask.end(), 0);
+        return 0;
+      }
+      int         item   = bankSchema.getEntryOrder(condition.name.c_str());
+      const char* values = getAddress() + 8 + bankSchema.getOffset(item, 0, nrows);
+      switch (bankSchema.getEntryType(item)) {
+      case 1:
+        selectColumn(reinterpret_cast<const int8_t*>(values), nrows, condition, &mask[0]);
+        break;
+      case 2:
+        selectColumn(reinterpret_cast<const int16_t*>(values), nrows, condition, &mask[0]);
+        break;
+      case 3:
+        selectColumn(reinterpret_cast<const int32_t*>(values), nrows, condition, &mask[0]);
+        break;
+      case 4:
+        selectColumn(reinterpret_cast<const float*>(values), nrows, condition, &mask[0]);
+        break;
+      case 5:
+        selectColumn(reinterpret_cast<const double*>(values), nrows, condition, &mask[0]);
+        break;
+      case 8:
+        selectColumn(reinterpret_cast<const int64_t*>(values), nrows, condition, &mask[0]);
+        break;
+      default:
+        break;
+      }
+    }
+    int selected = 0;
+    for (int i = 0; i < nrows; i++)
+      selected += mask[i];
+    return selected;
+  }
+
+  /**
+   * Same as above, but fills rows with the indices of the selected rows.
+   */
+  int bank::select(const hipo::selection& sel, std::vector<int>& rows) {
+    std::vector<uint8_t> mask;
+    select(sel, mask);
+    rows.clear();
+    for (int i = 0; i < (int)mask.size(); i++) {
+      if (mask[i] != 0)
+        rows.push_back(i);
+    }
+    return rows.size();
+  }
+
   int bank::getInt(int item, int index) {
     int type   = bankSchema.getEntryType(item);
     int offset = bankSchema.getOffset(item, index, bankRows);
@@ -0,0 +1,188 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/chain.h"
+#include <algorithm>
+#include <glob.h>
+
+namespace hipo {
+
+  chain::chain() {
+    fileEvents.push_back(0);
+    currentFile  = -1;
+    currentEvent = -1;
+  }
+
+  /**
+   * Adds all files matching the given glob pattern (or a single file name)
+   * to the chain, in alphabetical order. Returns the number of files added.
+   */
+  int chain::add(const char* pattern) {
+    std::vector<std::string> files;
+    glob_t                   globResult;
+    if (glob(pattern, 0, NULL, &globResult) == 0) {
+      for (size_t i = 0; i < globResult.gl_pathc; i++) {
+        files.push_back(globResult.gl_pathv[i]);
+      }
+    }
+    globfree(&globResult);
+    if (files.size() == 0) {
+      std::cerr << "[WARNING] no files found matching : " << pattern << std::endl;
+      return 0;
+    }
+    return add(files);
+  }
+
+  /**
+   * Sets the options of the chain (tags, memory mapping and prefetch) on
+   * a reader before it opens a file.
+   */
+  void chain::setOptions(hipo::reader& r) {
+    for (auto& tag : tagsToRead) {
+      r.setTags(tag);
+    }
+    r.setMemoryMapped(useMemoryMap);
+    r.setPrefetch(prefetchDepth);
+  }
+
+  /**
+   * Adds the files to the chain. Each file is opened once to append its
+   * index to the global event index of the chain, and closed again. Tags,
+   * memory mapping and prefetch have to be set before the files are added.
+   */
+  int chain::add(const std::vector<std::string>& files) {
+    for (int i = 0; i < (int)files.size(); i++) {
+      hipo::reader fileReader;
+      setOptions(fileReader);
+      fileReader.open(files[i].c_str());
+      if (chainFiles.size() == 0)
+        fileReader.readDictionary(chainDictionary);
+
+      hipo::chainFile_t file;
+      file.name            = files[i];
+      file.size            = fileReader.getFileSize();
+      file.header          = fileReader.getHeader();
+      file.index           = fileReader.getIndex();
+      file.dictionaryCodec = fileReader.getDictionaryCodec();
+      fileEvents.push_back(fileEvents.back() + fileReader.numEvents());
+      chainFiles.push_back(file);
+    }
+    return files.size();
+  }
+
+  /**
+   * Makes the given file the current one. The reader of the file that is
+   * left is closed (with its read-ahead thread), the reader of the new
+   * file is opened with the header, index and dictionary kept when the
+   * file was added. -1 closes the current file.
+   */
+  void chain::setFile(int fileNumber) {
+    if (fileNumber == currentFile)
+      return;
+    if (currentReader)
+      failedRecords += currentReader->getFailedRecords();
+    currentReader.reset();
+    if (fileNumber >= 0) {
+      const hipo::chainFile_t& file = chainFiles[fileNumber];
+      currentReader.reset(new hipo::reader());
+      setOptions(*currentReader);
+      currentReader->open(file.name.c_str(), file.header, file.index, file.dictionaryCodec);
+    }
+    currentFile = fileNumber;
+  }
+
+  /**
+   * Returns the number of records that could not be read, by next(),
+   * gotoEvent() and forEachParallel(), over all files.
+   */
+  long chain::getFailedRecords() {
+    if (currentReader)
+      return failedRecords + currentReader->getFailedRecords();
+    return failedRecords;
+  }
+
+  /**
+   * Returns the reader of the given file, which becomes the current file
+   * of the chain.
+   */
+  hipo::reader& chain::getReader(int fileNumber) {
+    setFile(fileNumber);
+    return *currentReader;
+  }
+
+  /**
+   * Copies the dictionary read from the first file of the chain, all
+   * files are expected to have the same dictionary.
+   */
+  void chain::readDictionary(hipo::dictionary& dict) { dict = chainDictionary; }
+
+  /**
+   * Moves to the next event of the chain, opening the next file at the
+   * end of a file. Records that can not be read are skipped by the reader
+   * of the file with a warning and counted by getFailedRecords(), they do
+   * not end the file. Returns false after the last event of the chain.
+   */
+  bool chain::next() {
+    if (currentFile < 0 && chainFiles.size() > 0)
+      setFile(0);
+    while (currentFile >= 0) {
+      if (currentReader->next() == true) {
+        currentEvent = fileEvents[currentFile] + currentReader->getEventNumber();
+        return true;
+      }
+      if (currentFile + 1 >= (int)chainFiles.size())
+        return false;
+      setFile(currentFile + 1);
+    }
+    return false;
+  }
+
+  bool chain::next(hipo::event& dataevent) {
+    if (next() == false)
+      return false;
+    read(dataevent);
+    return true;
+  }
+
+  void chain::read(hipo::event& dataevent) {
+    if (currentFile >= 0)
+      currentReader->read(dataevent);
+  }
+
+  void chain::read(hipo::eventView& dataevent) {
+    if (currentFile >= 0)
+      currentReader->read(dataevent);
+  }
+
+  /**
+   * Moves the chain to the given event number (counted from 0 over all
+   * files). The file is found by binary search in the cumulative event
+   * counts and the event within the file with reader::gotoEvent.
+   */
+  bool chain::gotoEvent(long eventNumber) {
+    if (eventNumber < 0 || eventNumber >= numEvents())
+      return false;
+    std::vector<long>::iterator it =
+        std::upper_bound(fileEvents.begin(), fileEvents.end(), eventNumber);
+    int fileNumber = (it - fileEvents.begin()) - 1;
+    setFile(fileNumber);
+    if (currentReader->gotoEvent(eventNumber - fileEvents[fileNumber]) == false)
+      return false;
+    currentEvent = eventNumber;
+    return true;
+  }
+
+  bool chain::readEvent(long eventNumber, hipo::event& dataevent) {
+    if (gotoEvent(eventNumber) == false)
+      return false;
+    read(dataevent);
+    return true;
+  }
+
+  void chain::rewind() {
+    setFile(-1);
+    currentEvent = -1;
+  }
+} // namespace hipo
@@ -0,0 +1,186 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/codec.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef __LZ4__
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+namespace hipo {
+
+  int codecNone::compress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    if (srcSize > dstCapacity)
+      return 0;
+    std::memcpy(dst, src, srcSize);
+    return srcSize;
+  }
+
+  int codecNone::decompress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    if (srcSize > dstCapacity)
+      return -1;
+    std::memcpy(dst, src, srcSize);
+    return srcSize;
+  }
+
+#ifdef __LZ4__
+  int codecLZ4::compress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    return LZ4_compress_fast(src, dst, srcSize, dstCapacity, acceleration);
+  }
+
+  int codecLZ4::decompress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    return LZ4_decompress_safe(src, dst, srcSize, dstCapacity);
+  }
+
+  int codecLZ4::decompressPartial(const char* src, char* dst, int srcSize,
+                                  int dstCapacity) const {
+    return LZ4_decompress_safe_partial(src, dst, srcSize, dstCapacity, dstCapacity);
+  }
+
+  int codecLZ4HC::compress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    return LZ4_compress_HC(src, dst, srcSize, dstCapacity, level);
+  }
+
+  // LZ4-HC produces a regular LZ4 block
+  int codecLZ4HC::decompress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    return LZ4_decompress_safe(src, dst, srcSize, dstCapacity);
+  }
+
+  int codecLZ4Dict::compress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    LZ4_stream_t* stream = LZ4_createStream();
+    if (dictionary.size() > 0)
+      LZ4_loadDict(stream, &dictionary[0], dictionary.size());
+    int result = LZ4_compress_fast_continue(stream, src, dst, srcSize, dstCapacity, acceleration);
+    LZ4_freeStream(stream);
+    return result;
+  }
+
+  int codecLZ4Dict::decompress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    if (dictionary.size() == 0)
+      return LZ4_decompress_safe(src, dst, srcSize, dstCapacity);
+    return LZ4_decompress_safe_usingDict(src, dst, srcSize, dstCapacity, &dictionary[0],
+                                         dictionary.size());
+  }
+#else
+  static void lz4NotSupported() {
+    std::cerr << "LZ4 compression is not supported." << std::endl;
+    std::cerr << "check if libz4 is installed on your system." << std::endl;
+    std::cerr << "recompile the library with liblz4 installed." << std::endl;
+  }
+
+  int codecLZ4::compress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    lz4NotSupported();
+    return 0;
+  }
+
+  int codecLZ4::decompress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    lz4NotSupported();
+    return -1;
+  }
+
+  int codecLZ4::decompressPartial(const char* src, char* dst, int srcSize,
+                                  int dstCapacity) const {
+    lz4NotSupported();
+    return -1;
+  }
+
+  int codecLZ4HC::compress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    lz4NotSupported();
+    return 0;
+  }
+
+  int codecLZ4HC::decompress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    lz4NotSupported();
+    return -1;
+  }
+
+  int codecLZ4Dict::compress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    lz4NotSupported();
+    return 0;
+  }
+
+  int codecLZ4Dict::decompress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    lz4NotSupported();
+    return -1;
+  }
+#endif
+
+  std::map<int, codecRegistry::entry_t> codecRegistry::builtin() {
+    std::map<int, entry_t> registry;
+    registry[kCompressionNone] = {"none", [](int level) -> codec* { return new codecNone(); },
+                                  std::shared_ptr<codec>(new codecNone())};
+    registry[kCompressionLZ4] = {
+        "lz4", [](int level) -> codec* { return level < 0 ? new codecLZ4() : new codecLZ4(level); },
+        std::shared_ptr<codec>(new codecLZ4())};
+    registry[kCompressionLZ4HC] = {
+        "lz4hc",
+        [](int level) -> codec* { return level < 0 ? new codecLZ4HC() : new codecLZ4HC(level); },
+        std::shared_ptr<codec>(new codecLZ4HC())};
+    registry[kCompressionLZ4Dict] = {
+        "lz4dict",
+        [](int level) -> codec* {
+          return level < 0 ? new codecLZ4Dict() : new codecLZ4Dict(level);
+        },
+        std::shared_ptr<codec>(new codecLZ4Dict())};
+    return registry;
+  }
+
+  /**
+   * The registry, filled with the built-in codecs on first use.
+   */
+  std::map<int, codecRegistry::entry_t>& codecRegistry::entries() {
+    static std::map<int, entry_t> registry = builtin();
+    return registry;
+  }
+
+  void codecRegistry::add(int type, const std::string& name, factory_t factory) {
+    if (type < 0 || type > 15) {
+      std::cerr << "---> error : compression type " << type << " does not fit the record header"
+                << std::endl;
+      return;
+    }
+    entries()[type] = {name, factory, std::shared_ptr<codec>(factory(-1))};
+  }
+
+  std::shared_ptr<codec> codecRegistry::create(int type, int level) {
+    std::map<int, entry_t>::iterator it = entries().find(type);
+    if (it == entries().end()) {
+      std::cerr << "---> error : unknown compression type " << type << std::endl;
+      return std::shared_ptr<codec>();
+    }
+    return std::shared_ptr<codec>(it->second.factory(level));
+  }
+
+  std::shared_ptr<codec> codecRegistry::create(const std::string& name, int level) {
+    int type = getType(name);
+    if (type < 0) {
+      std::cerr << "---> error : unknown compression [" << name << "]" << std::endl;
+      return std::shared_ptr<codec>();
+    }
+    return create(type, level);
+  }
+
+  /**
+   * Returns the shared instance used to decompress records of the given
+   * type, or NULL if the type is not registered.
+   */
+  const codec* codecRegistry::get(int type) {
+    std::map<int, entry_t>::iterator it = entries().find(type);
+    if (it == entries().end())
+      return NULL;
+    return it->second.instance.get();
+  }
+
+  int codecRegistry::getType(const std::string& name) {
+    for (auto& entry : entries()) {
+      if (entry.second.name == name)
+        return entry.first;
+    }
+    return -1;
+  }
+} // namespace hipo
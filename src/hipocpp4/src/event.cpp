@@ -8,6 +8,36 @@
 
 namespace hipo {
 
+  //====================================================================
+  // Implementation of eventIndex class
+  //====================================================================
+  void eventIndex::build(const char* buffer, int size) {
+    structurePositions.clear();
+    int position = 16;
+    while (position + 8 < size) {
+      uint16_t gid    = *(reinterpret_cast<const uint16_t*>(&buffer[position]));
+      uint8_t  iid    = *(reinterpret_cast<const uint8_t*>(&buffer[position + 2]));
+      int      length = *(reinterpret_cast<const int*>(&buffer[position + 4]));
+      // the first structure with given (group,item) is the one returned
+      structurePositions.emplace((gid << 8) | iid, std::make_pair(position, length));
+      position += (length + 8);
+    }
+    indexValid = true;
+  }
+
+  /**
+   * returns (position,length) of the structure in the event buffer, or
+   * (-1,0) if the event does not contain it.
+   */
+  std::pair<int, int> eventIndex::find(const char* buffer, int size, int group, int item) {
+    if (indexValid == false)
+      build(buffer, size);
+    auto it = structurePositions.find((group << 8) | item);
+    if (it == structurePositions.end())
+      return std::make_pair(-1, 0);
+    return it->second;
+  }
+
   event::event() {
 #if __cplusplus < 199711L
     std::cerr << "*****>>>>> NOT compiled with c++11 support." << std::endl;
@@ -45,6 +75,8 @@ namespace hipo {
     int evt_size     = getSize();
     int evt_capacity = dataBuffer.size();
 
+    structureIndex.invalidate();
+
     *(reinterpret_cast<uint32_t*>(&dataBuffer[4])) = (evt_size + str_size);
     if ((evt_size + str_size) < evt_capacity) {
       memcpy(&dataBuffer[evt_size], &str.getStructureBuffer()[0], str_size);
@@ -56,27 +88,18 @@ namespace hipo {
   }
 
   void event::init(std::vector<char>& buffer) {
+    structureIndex.invalidate();
     dataBuffer.resize(buffer.size());
     std::memcpy(&dataBuffer[0], &buffer[0], buffer.size());
   }
 
   std::pair<int, int> event::getStructurePosition(int group, int item) {
-    int position  = 16;
     int eventSize = *(reinterpret_cast<uint32_t*>(&dataBuffer[4]));
-    while (position + 8 < eventSize) {
-      uint16_t gid    = *(reinterpret_cast<uint16_t*>(&dataBuffer[position]));
-      uint8_t  iid    = *(reinterpret_cast<uint8_t*>(&dataBuffer[position + 2]));
-      uint8_t  type   = *(reinterpret_cast<uint8_t*>(&dataBuffer[position + 3]));
-      int      length = *(reinterpret_cast<int*>(&dataBuffer[position + 4]));
-      // printf("group = %4d , item = %4d\n",(unsigned int) gid, (unsigned int) iid);
-      if (gid == group && iid == item)
-        return std::make_pair(position, length);
-      position += (length + 8);
-    }
-    return std::make_pair(-1, 0);
+    return structureIndex.find(&dataBuffer[0], eventSize, group, item);
   }
 
   void event::init(const char* buffer, int size) {
+    structureIndex.invalidate();
     if (dataBuffer.size() <= size) {
       dataBuffer.resize(size);
     }
@@ -86,6 +109,7 @@ namespace hipo {
 
   int  event::getSize() { return *(reinterpret_cast<uint32_t*>(&dataBuffer[4])); }
   void event::reset() {
+    structureIndex.invalidate();
     dataBuffer[0]                                   = 'E';
     dataBuffer[1]                                   = 'V';
     dataBuffer[2]                                   = 'N';
@@ -94,13 +118,65 @@ namespace hipo {
     *(reinterpret_cast<uint32_t*>(&dataBuffer[8]))  = 0;
     *(reinterpret_cast<uint32_t*>(&dataBuffer[12])) = 0;
   }
-  std::vector<char>& event::getEventBuffer() { return dataBuffer; }
+  // the buffer can be modified by the caller, so the index is rebuilt
+  std::vector<char>& event::getEventBuffer() {
+    structureIndex.invalidate();
+    return dataBuffer;
+  }
   /*
   template<class T>   node<T> event::getNode(){
       node<T> en;
       en.setLength(4);
       en.setAddress(NULL);
   } */
+  //====================================================================
+  // Implementation of eventView class
+  //====================================================================
+  eventView::eventView() {
+    eventData = NULL;
+    eventSize = 0;
+  }
+
+  void eventView::init(const char* buffer, int size) {
+    structureIndex.invalidate();
+    eventData = buffer;
+    eventSize = size;
+  }
+
+  std::pair<int, int> eventView::getStructurePosition(int group, int item) {
+    return structureIndex.find(eventData, eventSize, group, item);
+  }
+
+  /**
+   * points the bank view to the bank data inside the event, no data is copied.
+   */
+  void eventView::getStructure(hipo::bankView& b) {
+    int                 group = b.getSchema().getGroup();
+    int                 item  = b.getSchema().getItem();
+    std::pair<int, int> index = getStructurePosition(group, item);
+    if (index.first > 0) {
+      b.setAddress(&eventData[index.first]);
+    } else {
+      b.initStructureBySize(group, item, 1, 0);
+    }
+    b.notify();
+  }
+
+  /**
+   * copies the bank data from the event into the bank.
+   */
+  void eventView::getStructure(hipo::bank& b) {
+    int                 group = b.getSchema().getGroup();
+    int                 item  = b.getSchema().getItem();
+    std::pair<int, int> index = getStructurePosition(group, item);
+    if (index.first > 0) {
+      b.init(&eventData[index.first], index.second + 8);
+    } else {
+      b.initStructureBySize(group, item, 1, 0);
+    }
+    b.notify();
+  }
+
   void event::show() {
     int position  = 16;
     int eventSize = *(reinterpret_cast<uint32_t*>(&dataBuffer[4]));
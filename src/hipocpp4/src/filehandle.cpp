@@ -0,0 +1,152 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/filehandle.h"
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace hipo {
+
+  fileHandle::~fileHandle() {
+    if (fileDescriptor >= 0)
+      ::close(fileDescriptor);
+  }
+
+  /**
+   * Opens the file and parses the header, the record index and the
+   * dictionaries once, with the same checks as reader::open(). Only
+   * records with one of the given tags are used if tags are given.
+   * Returns nullptr if the file can not be opened.
+   */
+  std::shared_ptr<fileHandle> fileHandle::open(const std::string& filename,
+                                               const std::vector<long>& tags) {
+    // checked first, reader::open() exits if the file does not exist
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      std::cerr << "[ERROR] something went wrong with openning file : " << filename << std::endl;
+      return nullptr;
+    }
+    std::shared_ptr<fileHandle> h(new fileHandle());
+    h->fileDescriptor = descriptor;
+
+    hipo::reader r;
+    for (auto& tag : tags)
+      r.setTags(tag);
+    r.open(filename.c_str());
+    h->fileName        = filename;
+    h->fileSize        = r.getFileSize();
+    h->recordIndex     = r.getIndex();
+    h->dictionaryCodec = r.getDictionaryCodec();
+    r.readDictionary(h->schemaDictionary);
+    return h;
+  }
+
+  /**
+   * Reads the record with given number (in the record index) into the
+   * given record. Safe to call from several threads with different
+   * records.
+   */
+  bool fileHandle::readRecord(hipo::record& rec, int recordNumber) const {
+    rec.setDictionaryCodec(dictionaryCodec);
+    return rec.readRecord(fileDescriptor, recordIndex.getPosition(recordNumber), fileSize);
+  }
+
+  /**
+   * Returns the record with given number from the record cache shared by
+   * the cursors of the handle, reading it into the cache if it is not
+   * there (see setCacheSize()). Returns nullptr if it can not be read.
+   */
+  std::shared_ptr<hipo::record> fileHandle::getCachedRecord(int recordNumber) const {
+    long                          position = recordIndex.getPosition(recordNumber);
+    std::shared_ptr<hipo::record> rec      = recordsCache.find(position);
+    if (rec == nullptr) {
+      rec = recordsCache.create();
+      if (readRecord(*rec, recordNumber) == false)
+        return nullptr;
+      recordsCache.insert(position, rec);
+    }
+    return rec;
+  }
+
+  /**
+   * Restricts reading to the given banks, see reader::setBanks(). A cursor
+   * reading a subset of the banks does not use the record cache of the
+   * handle, which holds complete records.
+   */
+  void fileCursor::setBanks(const std::vector<std::string>& names) {
+    hipo::dictionary dict;
+    handle->readDictionary(dict);
+    structuresToRead.clear();
+    for (auto& name : names) {
+      if (dict.hasSchema(name.c_str()) == false) {
+        std::cerr << "---> error : bank [" << name << "] is not in the dictionary" << std::endl;
+        continue;
+      }
+      hipo::schema& schema = dict.getSchema(name.c_str());
+      structuresToRead.push_back((schema.getGroup() << 8) | schema.getItem());
+    }
+    cursorRecord.setStructureFilter(structuresToRead);
+    currentRecord = -1;
+  }
+
+  bool fileCursor::loadRecord(int recordNumber) {
+    currentRecord = -1;
+    cachedRecord.reset();
+    recordInUse = &cursorRecord;
+    if (handle->isCacheEnabled() == true && structuresToRead.size() == 0) {
+      cachedRecord = handle->getCachedRecord(recordNumber);
+      if (cachedRecord == nullptr)
+        return false;
+      recordInUse = cachedRecord.get();
+    } else if (handle->readRecord(cursorRecord, recordNumber) == false) {
+      return false;
+    }
+    currentRecord = recordNumber;
+    return true;
+  }
+
+  bool fileCursor::next(hipo::event& dataevent) {
+    if (hasNext() == false)
+      return false;
+    return readEvent(currentEvent + 1, dataevent);
+  }
+
+  /**
+   * Moves the cursor to the event with given number, reading the record
+   * containing it if it is not the current one. Returns false if the
+   * event is out of range or the record can not be read.
+   */
+  bool fileCursor::gotoEvent(long eventNumber) {
+    const hipo::readerIndex& index = handle->getIndex();
+    if (eventNumber < 0 || eventNumber >= index.getMaxEvents())
+      return false;
+    int recordNumber = currentRecord;
+    if (recordNumber < 0 || eventNumber < index.getFirstEvent(recordNumber) ||
+        eventNumber >= index.getFirstEvent(recordNumber + 1)) {
+      recordNumber = index.findRecord(eventNumber);
+      if (loadRecord(recordNumber) == false)
+        return false;
+    }
+    currentEvent = eventNumber;
+    return true;
+  }
+
+  bool fileCursor::readEvent(long eventNumber, hipo::event& dataevent) {
+    if (gotoEvent(eventNumber) == false)
+      return false;
+    read(dataevent);
+    return true;
+  }
+
+  void fileCursor::read(hipo::event& dataevent) {
+    const hipo::readerIndex& index = handle->getIndex();
+    if (currentEvent < 0)
+      return;
+    if (currentRecord < 0 && loadRecord(index.findRecord(currentEvent)) == false)
+      return;
+    recordInUse->readHipoEvent(dataevent, currentEvent - index.getFirstEvent(currentRecord));
+  }
+} // namespace hipo
@@ -0,0 +1,206 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/prefetcher.h"
+#include <algorithm>
+
+namespace hipo {
+
+  prefetcher::prefetcher() {
+    mappedBuffer   = NULL;
+    mappedSize     = 0;
+    fileDescriptor = -1;
+    directIO       = false;
+    nextToRead     = 0;
+    currentRecord  = -1;
+    stopRequested  = false;
+  }
+
+  prefetcher::~prefetcher() { close(); }
+
+  /**
+   * Prepares the read-ahead of the records at given positions. If the buffer
+   * is not NULL records are read from the memory mapped file, otherwise the
+   * prefetcher opens its own stream, so it does not interfere with the
+   * stream of the reader. The ring holds depth records read ahead, plus
+   * the record currently used by the consumer. The dictionary codec is
+   * passed to the records for files compressed with a dictionary, the
+   * structures select the chunks read from columnar records and threads
+   * decompress block compressed records. With asyncIO the records of the
+   * read-ahead window are read in one batch with io_uring, if available
+   * (see uring.h), instead of one blocking read per record, using the
+   * record lengths of the file index. Otherwise,
+   * if a descriptor is given, records are read from it with pread(), or
+   * with readRecordDirect() if it was opened with O_DIRECT (direct).
+   */
+  void prefetcher::open(const char* filename, const char* buffer, long size,
+                        const std::vector<long>& recordPositions,
+                        const std::vector<long>& recordLengths, int depth,
+                        std::shared_ptr<hipo::codec> dictionaryCodec,
+                        const std::vector<int>&      structures, int threads, bool asyncIO,
+                        int descriptor, bool direct) {
+    close();
+    fileName       = filename;
+    mappedBuffer   = buffer;
+    mappedSize     = size;
+    positions      = recordPositions;
+    lengths        = recordLengths;
+    fileDescriptor = descriptor;
+    directIO       = direct;
+    if (depth < 1)
+      depth = 1;
+    ringStatus.assign(depth + 1, 0);
+    for (int i = 0; i < depth + 1; i++) {
+      ring.push_back(std::unique_ptr<hipo::record>(new hipo::record()));
+      ring.back()->setDictionaryCodec(dictionaryCodec);
+      ring.back()->setStructureFilter(structures);
+      ring.back()->setDecompressionThreads(threads);
+    }
+    if (mappedBuffer == NULL) {
+      inputStream.open(filename, std::ios::binary);
+      if (asyncIO == true && lengths.size() == positions.size() &&
+          uring.open(filename, depth) == true) {
+        ringBuffers.resize(ring.size());
+      }
+    }
+  }
+
+  void prefetcher::close() {
+    stop();
+    ring.clear();
+    ringStatus.clear();
+    ringBuffers.clear();
+    positions.clear();
+    lengths.clear();
+    uring.close();
+    if (inputStream.is_open() == true) {
+      inputStream.close();
+    }
+  }
+
+  void prefetcher::start(int firstRecord) {
+    stop();
+    nextToRead    = firstRecord;
+    currentRecord = firstRecord;
+    stopRequested = false;
+    worker        = std::thread(&prefetcher::run, this);
+  }
+
+  void prefetcher::stop() {
+    if (worker.joinable() == false)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(ringMutex);
+      stopRequested = true;
+    }
+    ringCondition.notify_all();
+    worker.join();
+  }
+
+  /**
+   * Worker loop, reads records in order as long as there is a free
+   * slot in the ring. The slot of the record held by the consumer
+   * is never overwritten.
+   */
+  void prefetcher::run() {
+    std::unique_lock<std::mutex> lock(ringMutex);
+    int                          ringSize = ring.size();
+    while (true) {
+      ringCondition.wait(lock, [this, ringSize] {
+        return stopRequested ||
+               (nextToRead < (int)positions.size() && nextToRead < currentRecord + ringSize);
+      });
+      if (stopRequested == true)
+        return;
+      int recordNumber = nextToRead;
+      if (uring.isOpen() == true) {
+        int last = std::min((int)positions.size(), currentRecord + ringSize);
+        lock.unlock();
+        readBatch(recordNumber, last);
+        lock.lock();
+        continue;
+      }
+      lock.unlock();
+      bool status = readRecord(*ring[recordNumber % ringSize], recordNumber);
+      lock.lock();
+      ringStatus[recordNumber % ringSize] = status;
+      nextToRead++;
+      ringCondition.notify_all();
+    }
+  }
+
+  /**
+   * Reads the record with given number into rec, from the memory mapped
+   * file, the descriptor or the stream of the prefetcher. Returns false
+   * if the record can not be read or decompressed.
+   */
+  bool prefetcher::readRecord(hipo::record& rec, int recordNumber) {
+    if (mappedBuffer != NULL)
+      return rec.readRecord(mappedBuffer, positions[recordNumber], mappedSize);
+    if (fileDescriptor >= 0 && directIO == true)
+      return rec.readRecordDirect(fileDescriptor, positions[recordNumber], mappedSize);
+    if (fileDescriptor >= 0)
+      return rec.readRecord(fileDescriptor, positions[recordNumber], mappedSize);
+    return rec.readRecord(inputStream, positions[recordNumber], 0, mappedSize);
+  }
+
+  /**
+   * Reads the records first to last-1 (free slots of the ring) with one
+   * io_uring batch and decodes them in order, each record is handed to
+   * the consumer as soon as it is decoded. Falls back to the stream if
+   * the batch can not be read.
+   */
+  void prefetcher::readBatch(int first, int last) {
+    int                               ringSize = ring.size();
+    std::vector<long>                 batchPositions;
+    std::vector<long>                 batchLengths;
+    std::vector<hipo::alignedBuffer*> buffers;
+    for (int i = first; i < last; i++) {
+      batchPositions.push_back(positions[i]);
+      batchLengths.push_back(lengths[i]);
+      buffers.push_back(&ringBuffers[i % ringSize]);
+    }
+    bool batchRead = uring.readRecords(batchPositions, batchLengths, buffers);
+    for (int i = first; i < last; i++) {
+      hipo::record* rec = ring[i % ringSize].get();
+      bool          status;
+      if (batchRead == true) {
+        hipo::alignedBuffer& buffer = ringBuffers[i % ringSize];
+        status                      = rec->readRecord(buffer.data(), 0, buffer.size());
+      } else {
+        status = readRecord(*rec, i);
+      }
+      std::lock_guard<std::mutex> lock(ringMutex);
+      ringStatus[i % ringSize] = status;
+      nextToRead++;
+      ringCondition.notify_all();
+    }
+  }
+
+  /**
+   * Returns the record with given number once it has been read by the
+   * worker. Records are expected to be requested in increasing order,
+   * requesting a record outside of the read-ahead window restarts the
+   * worker from that record. The returned record stays valid until the
+   * next call. Returns NULL if the record number is out of range or the
+   * record can not be read.
+   */
+  hipo::record* prefetcher::getRecord(int recordNumber) {
+    if (recordNumber < 0 || recordNumber >= (int)positions.size())
+      return NULL;
+    std::unique_lock<std::mutex> lock(ringMutex);
+    if (worker.joinable() == false || recordNumber < currentRecord || recordNumber > nextToRead) {
+      lock.unlock();
+      start(recordNumber);
+      lock.lock();
+    }
+    currentRecord = recordNumber;
+    ringCondition.notify_all();
+    ringCondition.wait(lock, [this, recordNumber] { return nextToRead > recordNumber; });
+    if (ringStatus[recordNumber % ring.size()] == 0)
+      return NULL;
+    return ring[recordNumber % ring.size()].get();
+  }
+} // namespace hipo
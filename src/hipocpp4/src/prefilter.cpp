@@ -0,0 +1,242 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/prefilter.h"
+#include <cstring>
+
+namespace hipo {
+
+  // filters stored in the upper 4 bits of the column code
+  static const int kColumnShuffle = 1;
+  static const int kColumnDelta   = 2;
+
+  int prefilter::getTypeSize(int type) {
+    switch (type) {
+    case 1:
+      return 1;
+    case 2:
+      return 2;
+    case 3:
+    case 4:
+      return 4;
+    case 5:
+    case 8:
+      return 8;
+    default:
+      return 0;
+    }
+  }
+
+  /**
+   * Decides which columns of every bank in the dictionary are filtered:
+   * float and double columns are shuffled with kPrefilterShuffle, integer
+   * columns with a name in deltaColumns are delta-encoded with
+   * kPrefilterDelta. Banks without any filtered column are left out.
+   */
+  void prefilter::setFilters(hipo::dictionary& dict, int flags,
+                             const std::vector<std::string>& deltaColumns) {
+    bankColumns.clear();
+    std::vector<std::string> schemaList = dict.getSchemaList();
+    for (auto& name : schemaList) {
+      hipo::schema& schema = dict.getSchema(name);
+      if (schema.getEntries() > 255)
+        continue;
+      std::vector<uint8_t> columns;
+      bool                 filtered = false;
+      for (int i = 0; i < schema.getEntries(); i++) {
+        int type   = schema.getEntryType(i);
+        int filter = 0;
+        if ((flags & kPrefilterShuffle) != 0 && (type == 4 || type == 5))
+          filter = kColumnShuffle;
+        if ((flags & kPrefilterDelta) != 0 && (type == 1 || type == 2 || type == 3 || type == 8)) {
+          for (auto& column : deltaColumns) {
+            if (column == schema.getEntryName(i))
+              filter = kColumnDelta;
+          }
+        }
+        filtered = filtered || (filter != 0);
+        columns.push_back((uint8_t)((filter << 4) | (type & 0x0F)));
+      }
+      if (filtered == true)
+        bankColumns[(schema.getGroup() << 8) | schema.getItem()] = columns;
+    }
+  }
+
+  /**
+   * Reads the header of the structure, returns false if it is not a bank.
+   */
+  bool prefilter::getBank(const char* structure, int& key, int& length) {
+    uint16_t group = *(reinterpret_cast<const uint16_t*>(structure));
+    uint8_t  item  = *(reinterpret_cast<const uint8_t*>(structure + 2));
+    uint8_t  type  = *(reinterpret_cast<const uint8_t*>(structure + 3));
+    key            = (group << 8) | item;
+    length         = *(reinterpret_cast<const int*>(structure + 4));
+    return type == 11;
+  }
+
+  void prefilter::shuffle(char* data, int rows, int size) {
+    int bytes = rows * size;
+    if (scratch.size() < (size_t)bytes)
+      scratch.resize(bytes);
+    for (int i = 0; i < rows; i++)
+      for (int b = 0; b < size; b++)
+        scratch[b * rows + i] = data[i * size + b];
+    std::memcpy(data, &scratch[0], bytes);
+  }
+
+  void prefilter::unshuffle(char* data, int rows, int size) {
+    int bytes = rows * size;
+    if (scratch.size() < (size_t)bytes)
+      scratch.resize(bytes);
+    for (int i = 0; i < rows; i++)
+      for (int b = 0; b < size; b++)
+        scratch[i * size + b] = data[b * rows + i];
+    std::memcpy(data, &scratch[0], bytes);
+  }
+
+  // differences are taken in unsigned arithmetic, so they wrap and the
+  // decoding restores the exact values
+  template <typename T>
+  static void deltaEncodeColumn(char* data, int rows) {
+    T* values   = reinterpret_cast<T*>(data);
+    T  previous = 0;
+    for (int i = 0; i < rows; i++) {
+      T value   = values[i];
+      values[i] = value - previous;
+      previous  = value;
+    }
+  }
+
+  template <typename T>
+  static void deltaDecodeColumn(char* data, int rows) {
+    T* values = reinterpret_cast<T*>(data);
+    T  sum    = 0;
+    for (int i = 0; i < rows; i++) {
+      sum += values[i];
+      values[i] = sum;
+    }
+  }
+
+  void prefilter::deltaEncode(char* data, int rows, int size) {
+    switch (size) {
+    case 1:
+      return deltaEncodeColumn<uint8_t>(data, rows);
+    case 2:
+      return deltaEncodeColumn<uint16_t>(data, rows);
+    case 4:
+      return deltaEncodeColumn<uint32_t>(data, rows);
+    case 8:
+      return deltaEncodeColumn<uint64_t>(data, rows);
+    }
+  }
+
+  void prefilter::deltaDecode(char* data, int rows, int size) {
+    switch (size) {
+    case 1:
+      return deltaDecodeColumn<uint8_t>(data, rows);
+    case 2:
+      return deltaDecodeColumn<uint16_t>(data, rows);
+    case 4:
+      return deltaDecodeColumn<uint32_t>(data, rows);
+    case 8:
+      return deltaDecodeColumn<uint64_t>(data, rows);
+    }
+  }
+
+  /**
+   * Walks over the banks of all events in the buffer and applies the
+   * column filters (or reverses them) to banks with known columns. The
+   * keys of the banks that were changed are added to used.
+   */
+  void prefilter::apply(char* events, int size, bool forward, std::map<int, bool>& used) {
+    int position = 0;
+    while (position + 16 <= size) {
+      int eventSize = *(reinterpret_cast<const int*>(events + position + 4));
+      if (eventSize < 16 || position + eventSize > size)
+        break;
+      int offset = position + 16;
+      while (offset + 8 <= position + eventSize) {
+        int  key, length;
+        bool isBank = getBank(events + offset, key, length);
+        if (length < 0 || offset + 8 + length > position + eventSize)
+          break;
+        if (isBank == true) {
+          std::map<int, std::vector<uint8_t>>::iterator it = bankColumns.find(key);
+          if (it != bankColumns.end()) {
+            std::vector<uint8_t>& columns   = it->second;
+            int                   rowLength = 0;
+            for (auto& code : columns)
+              rowLength += getTypeSize(code & 0x0F);
+            if (rowLength > 0 && length % rowLength == 0) {
+              int   rows = length / rowLength;
+              char* data = events + offset + 8;
+              for (auto& code : columns) {
+                int typeSize = getTypeSize(code & 0x0F);
+                if ((code >> 4) == kColumnShuffle) {
+                  if (forward == true)
+                    shuffle(data, rows, typeSize);
+                  else
+                    unshuffle(data, rows, typeSize);
+                }
+                if ((code >> 4) == kColumnDelta) {
+                  if (forward == true)
+                    deltaEncode(data, rows, typeSize);
+                  else
+                    deltaDecode(data, rows, typeSize);
+                }
+                data += rows * typeSize;
+              }
+              used[key] = true;
+            }
+          }
+        }
+        offset += length + 8;
+      }
+      position += eventSize;
+    }
+  }
+
+  /**
+   * Filters the banks of all events in the buffer in place and fills the
+   * layout table with the banks that were filtered.
+   */
+  void prefilter::encode(char* events, int size, std::vector<char>& layout) {
+    std::map<int, bool> used;
+    apply(events, size, true, used);
+
+    layout.clear();
+    for (auto& entry : used) {
+      std::vector<uint8_t>& columns = bankColumns[entry.first];
+      uint16_t              group   = (uint16_t)(entry.first >> 8);
+      layout.push_back((char)(group & 0xFF));
+      layout.push_back((char)(group >> 8));
+      layout.push_back((char)(entry.first & 0xFF));
+      layout.push_back((char)columns.size());
+      for (auto& code : columns)
+        layout.push_back((char)code);
+    }
+  }
+
+  /**
+   * Reverses the filters on all events in the buffer, the columns of each
+   * bank are taken from the layout table stored with the record.
+   */
+  void prefilter::decode(char* events, int size, const char* layout, int layoutSize) {
+    bankColumns.clear();
+    int position = 0;
+    while (position + 4 <= layoutSize) {
+      int group    = *(reinterpret_cast<const uint16_t*>(layout + position));
+      int item     = *(reinterpret_cast<const uint8_t*>(layout + position + 2));
+      int ncolumns = *(reinterpret_cast<const uint8_t*>(layout + position + 3));
+      if (position + 4 + ncolumns > layoutSize)
+        break;
+      const uint8_t* codes = reinterpret_cast<const uint8_t*>(layout + position + 4);
+      bankColumns[(group << 8) | item].assign(codes, codes + ncolumns);
+      position += 4 + ncolumns;
+    }
+    std::map<int, bool> used;
+    apply(events, size, false, used);
+  }
+} // namespace hipo
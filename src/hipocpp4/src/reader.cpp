@@ -6,8 +6,13 @@
 #include "hipo4/reader.h"
 #include "hipo4/hipoexceptions.h"
 #include "hipo4/record.h"
+#include <algorithm>
 #include <cstdlib>
+#include <fcntl.h>
 #include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
 /**
  * HIPO namespace is used for the classes that read write
  * files and records.
@@ -24,9 +29,12 @@ namespace hipo {
    * Default destructor. Does nothing
    */
   reader::~reader() {
+    recordPrefetcher.close();
     if (inputStream.is_open() == true) {
       inputStream.close();
     }
+    unmapFile();
+    closePageCacheDescriptor();
   }
   /**
    * Open file, if file stream is open, it is closed first.
@@ -36,11 +44,41 @@ namespace hipo {
    */
 
   void reader::open(const char* filename) {
+    openFile(filename);
+    readHeader();
+    // the trailer index record can be compressed with the dictionary
+    readCompressionDictionary();
+    readIndex();
+  }
 
+  /**
+   * Opens the file with the header, record index and compression
+   * dictionary read by an earlier reader of the same file (getHeader(),
+   * getIndex() and getDictionaryCodec()), which are not read again. The
+   * index must have been read with the same tags and filters. Used by
+   * chain to reopen its files.
+   */
+  void reader::open(const char* filename, const hipo::fileHeader_t& fileHeader,
+                    const hipo::readerIndex& index, std::shared_ptr<hipo::codec> codec) {
+    openFile(filename);
+    header           = fileHeader;
+    dictionaryCodec  = codec;
+    readerEventIndex = index;
+    readerEventIndex.rewind();
+  }
+
+  /**
+   * Opens the input stream (and the memory mapping or page cache
+   * descriptor), forgetting everything read from the previous file.
+   */
+  void reader::openFile(const char* filename) {
+    resetRecords();
     if (inputStream.is_open() == true) {
       inputStream.close();
     }
+    unmapFile();
 
+    inputFileName = filename;
     inputStream.open(filename, std::ios::binary);
     inputStream.seekg(0, std::ios_base::end);
     inputStreamSize = inputStream.tellg();
@@ -49,8 +87,353 @@ namespace hipo {
       std::cerr << "[ERROR] something went wrong with openning file : " << filename << std::endl;
       exit(1);
     }
-    readHeader();
-    readIndex();
+    if (useMemoryMap == true) {
+      mapFile(filename);
+    }
+    openPageCacheDescriptor();
+    dictionaryCodec.reset();
+    lookupIndex.clear();
+    lookupIndexLoaded = false;
+  }
+
+  /**
+   * Maps the entire file into memory (read only). Records are then
+   * read directly from the mapping, which avoids copying the data into
+   * the record buffers and lets processes reading the same file share
+   * the page cache. If mapping fails the reader falls back to the stream.
+   */
+  void reader::mapFile(const char* filename) {
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+      std::cerr << "[WARNING] can not open file for memory mapping : " << filename << std::endl;
+      return;
+    }
+    void* ptr = mmap(NULL, inputStreamSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+      std::cerr << "[WARNING] memory mapping failed, reading file : " << filename << std::endl;
+      return;
+    }
+    madvise(ptr, inputStreamSize, MADV_SEQUENTIAL);
+    mappedBuffer = reinterpret_cast<const char*>(ptr);
+  }
+
+  void reader::unmapFile() {
+    if (mappedBuffer != NULL) {
+      munmap(const_cast<char*>(mappedBuffer), inputStreamSize);
+      mappedBuffer = NULL;
+    }
+  }
+
+  /**
+   * Reads the record at given position, from the memory mapped
+   * file if it is mapped, otherwise from the input stream. Returns
+   * false if the record can not be read or decompressed.
+   */
+  bool reader::readRecord(hipo::record& rec, long position) {
+    return readRecord(rec, inputStream, position);
+  }
+
+  /**
+   * Same as above, but reads from the given stream if the file is not
+   * mapped. Used by threads that can not share the reader's stream, each
+   * with its own record and stream (see forEachParallel and runIndex).
+   * If selected is false all banks of columnar records are read, not only
+   * the ones selected with setBanks().
+   */
+  bool reader::readRecord(hipo::record& rec, std::ifstream& stream, long position,
+                          bool selected) const {
+    rec.setDictionaryCodec(dictionaryCodec);
+    rec.setStructureFilter(selected ? structuresToRead : std::vector<int>());
+    rec.setDecompressionThreads(decompressionThreads);
+    if (mappedBuffer != NULL)
+      return rec.readRecord(mappedBuffer, position, inputStreamSize);
+    if (pageCacheDescriptor >= 0 && pageCachePolicy == kPageCacheDirect)
+      return rec.readRecordDirect(pageCacheDescriptor, position, inputStreamSize);
+    if (pageCacheDescriptor >= 0)
+      return rec.readRecord(pageCacheDescriptor, position, inputStreamSize);
+    return rec.readRecord(stream, position, 0, inputStreamSize);
+  }
+
+  /**
+   * Controls how reading the file uses the page cache of the system, so
+   * large one pass scans (dst2root, skims) do not evict the cached files
+   * of other users on shared nodes. kPageCacheStreaming reads records
+   * with a sequential access hint, asks the kernel to read the next
+   * record ahead and drops the pages of the records already read.
+   * kPageCacheDirect reads records with O_DIRECT into block aligned
+   * buffers, bypassing the page cache (falls back to streaming if the
+   * file system does not support it). kPageCacheDefault leaves the page
+   * cache to the kernel. Not used for memory mapped files.
+   */
+  void reader::setPageCachePolicy(int policy) {
+    // the read-ahead uses the descriptor, stop it first
+    resetRecords();
+    pageCachePolicy = policy;
+    if (inputFileName.size() > 0)
+      openPageCacheDescriptor();
+  }
+
+  void reader::openPageCacheDescriptor() {
+    closePageCacheDescriptor();
+    pageCacheDropped = 0;
+    if (pageCachePolicy == kPageCacheDefault)
+      return;
+    if (pageCachePolicy == kPageCacheDirect) {
+      pageCacheDescriptor = ::open(inputFileName.c_str(), O_RDONLY | O_DIRECT);
+      // some file systems accept O_DIRECT at open time but fail the reads
+      void* block = NULL;
+      if (pageCacheDescriptor >= 0 &&
+          posix_memalign(&block, record::directAlignment, record::directAlignment) == 0) {
+        if (::pread(pageCacheDescriptor, block, record::directAlignment, 0) < 0)
+          closePageCacheDescriptor();
+        free(block);
+      }
+      if (pageCacheDescriptor >= 0)
+        return;
+      std::cerr << "[WARNING] O_DIRECT is not supported for file : " << inputFileName
+                << ", using streaming page cache policy" << std::endl;
+      pageCachePolicy = kPageCacheStreaming;
+    }
+    pageCacheDescriptor = ::open(inputFileName.c_str(), O_RDONLY);
+    if (pageCacheDescriptor < 0) {
+      std::cerr << "[WARNING] can not open file for page cache control : " << inputFileName
+                << std::endl;
+      return;
+    }
+    posix_fadvise(pageCacheDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+
+  void reader::closePageCacheDescriptor() {
+    if (pageCacheDescriptor >= 0 && pageCachePolicy == kPageCacheStreaming)
+      posix_fadvise(pageCacheDescriptor, pageCacheDropped, 0, POSIX_FADV_DONTNEED);
+    if (pageCacheDescriptor >= 0)
+      ::close(pageCacheDescriptor);
+    pageCacheDescriptor = -1;
+  }
+
+  /**
+   * Streaming policy: drops the pages before the given record and asks
+   * for the next record to be read ahead.
+   */
+  void reader::advisePageCache(int recordNumber) {
+    if (pageCacheDescriptor < 0 || pageCachePolicy != kPageCacheStreaming)
+      return;
+    long position = readerEventIndex.getPosition(recordNumber);
+    if (position > pageCacheDropped) {
+      posix_fadvise(pageCacheDescriptor, pageCacheDropped, position - pageCacheDropped,
+                    POSIX_FADV_DONTNEED);
+      pageCacheDropped = position;
+    }
+    int nrecords = readerEventIndex.getMaxRecords();
+    if (recordNumber + 1 < nrecords) {
+      long next   = readerEventIndex.getPosition(recordNumber + 1);
+      long length = 0; // to the end of the file
+      if (recordNumber + 2 < nrecords)
+        length = readerEventIndex.getPosition(recordNumber + 2) - next;
+      posix_fadvise(pageCacheDescriptor, next, length, POSIX_FADV_WILLNEED);
+    }
+  }
+
+  /**
+   * Enables reading ahead of depth records on a background thread while
+   * the current record is processed, 0 disables the read-ahead. The events
+   * are still accessed through next() and read().
+   */
+  void reader::setPrefetch(int depth) {
+    resetRecords();
+    prefetchDepth = depth;
+  }
+
+  /**
+   * Reads the records of the read-ahead window (see setPrefetch()) in one
+   * batch with Linux io_uring, which keeps many reads in flight and is
+   * needed to saturate NVMe drives. Requires the library to be built with
+   * USE_IO_URING, otherwise (or if the kernel does not allow io_uring)
+   * records are read with the stream. Not used for memory mapped files.
+   */
+  void reader::setAsyncIO(bool flag) {
+    if (flag == true && uringReader::isAvailable() == false) {
+      std::cerr << "[WARNING] io_uring is not available, reading records with the stream"
+                << std::endl;
+      flag = false;
+    }
+    useAsyncIO = flag;
+    resetRecords();
+  }
+
+  /**
+   * Reads the event with given run and event number (RUN::config) using
+   * the lookup index of the file (see runIndex and the hipoindex tool),
+   * without changing the current position of the reader. Returns false if
+   * the event is not in the index, or there is no up to date index.
+   */
+  bool reader::findEvent(int run, int event, hipo::event& dataevent) {
+    if (lookupIndexLoaded == false) {
+      lookupIndexLoaded = true;
+      std::string indexName = runIndex::getIndexName(inputFileName);
+      if (lookupIndex.read(indexName) == false) {
+        std::cerr << "[WARNING] no event index " << indexName << " for this file" << std::endl;
+      } else if (lookupIndex.getFileSize() != inputStreamSize) {
+        std::cerr << "[WARNING] event index " << indexName << " is out of date" << std::endl;
+        lookupIndex.clear();
+      }
+    }
+    long position;
+    int  index;
+    if (lookupIndex.find(run, event, position, index) == false)
+      return false;
+    if (recordsCache.isEnabled() == true) {
+      std::shared_ptr<hipo::record> rec = getCachedRecord(position);
+      if (rec == nullptr)
+        return false;
+      rec->readHipoEvent(dataevent, index);
+      return true;
+    }
+    if (position != lookupRecordPosition) {
+      lookupRecordPosition = -1;
+      if (readRecord(lookupRecord, position) == false)
+        return false;
+      lookupRecordPosition = position;
+    }
+    lookupRecord.readHipoEvent(dataevent, index);
+    return true;
+  }
+
+  /**
+   * Restricts reading to the given banks. Columnar records (see record.h)
+   * then only decompress the chunks of these banks, events contain no
+   * other banks. Records in the row layout are read entirely. Must be
+   * called after open(), the current record is read again with the new
+   * selection. An empty list reads all banks again.
+   */
+  void reader::setBanks(const std::vector<std::string>& names) {
+    hipo::dictionary dict;
+    readDictionary(dict);
+    structuresToRead.clear();
+    for (auto& name : names) {
+      if (dict.hasSchema(name.c_str()) == false) {
+        std::cerr << "---> error : bank [" << name << "] is not in the dictionary" << std::endl;
+        continue;
+      }
+      hipo::schema& schema = dict.getSchema(name.c_str());
+      structuresToRead.push_back((schema.getGroup() << 8) | schema.getItem());
+    }
+    resetRecords();
+  }
+
+  /**
+   * Sets the number of threads decompressing a block compressed record
+   * (see writer::setBlockSize), this lowers the time to get the next
+   * record when a single consumer reads the file. Other records are
+   * decompressed by one thread.
+   */
+  void reader::setDecompressionThreads(int n) {
+    decompressionThreads = (n > 0) ? n : 1;
+    resetRecords();
+  }
+
+  /**
+   * Keeps up to bytes of decompressed records in memory (LRU), so events
+   * accessed out of order through gotoEvent(), readEvent(), findEvent()
+   * or next() after a jump do not read and decompress the same record
+   * again. 0 disables the cache. Not used when records are prefetched.
+   * The hit and miss counters (getCacheHits(), getCacheMisses()) help
+   * to size the cache, a typical record takes 8-10 MB.
+   */
+  void reader::setCacheSize(long bytes) {
+    recordsCache.setMaxSize(bytes);
+    if (bytes <= 0)
+      resetRecords();
+  }
+
+  /**
+   * Forgets all records read (current record, read-ahead ring, record
+   * cache), needed when the file or the decompressed content changes.
+   */
+  void reader::resetRecords() {
+    recordPrefetcher.close();
+    recordsCache.clear();
+    cachedRecord.reset();
+    currentRecord        = &inputRecord;
+    loadedRecord         = -1;
+    lookupRecordPosition = -1;
+  }
+
+  /**
+   * Returns the record at given position from the record cache, reading
+   * it into the cache if it is not there. Returns nullptr if the record
+   * can not be read, records that failed are not cached.
+   */
+  std::shared_ptr<hipo::record> reader::getCachedRecord(long position) {
+    std::shared_ptr<hipo::record> rec = recordsCache.find(position);
+    if (rec == nullptr) {
+      rec = recordsCache.create();
+      if (readRecord(*rec, position) == false)
+        return nullptr;
+      recordsCache.insert(position, rec);
+    }
+    return rec;
+  }
+
+  /**
+   * Makes the record with given number (in the reader index) the current
+   * record, either from the read-ahead ring, the record cache or by
+   * reading it directly. Returns false if the record can not be read,
+   * the events of a record that failed are not read until the settings
+   * of the reader change (resetRecords()).
+   */
+  bool reader::loadRecord(int recordNumber) {
+    bool loaded;
+    if (prefetchDepth > 0) {
+      if (recordPrefetcher.isOpen() == false) {
+        std::vector<long> positions;
+        std::vector<long> lengths;
+        for (int i = 0; i < readerEventIndex.getMaxRecords(); i++) {
+          positions.push_back(readerEventIndex.getPosition(i));
+          lengths.push_back(readerEventIndex.getLength(i));
+        }
+        recordPrefetcher.open(inputFileName.c_str(), mappedBuffer, inputStreamSize, positions,
+                              lengths, prefetchDepth, dictionaryCodec, structuresToRead,
+                              decompressionThreads, useAsyncIO, pageCacheDescriptor,
+                              pageCachePolicy == kPageCacheDirect);
+      }
+      currentRecord = recordPrefetcher.getRecord(recordNumber);
+      loaded        = currentRecord != NULL;
+    } else if (recordsCache.isEnabled() == true) {
+      cachedRecord  = getCachedRecord(readerEventIndex.getPosition(recordNumber));
+      currentRecord = cachedRecord.get();
+      loaded        = currentRecord != NULL;
+    } else {
+      loaded        = readRecord(inputRecord, readerEventIndex.getPosition(recordNumber));
+      currentRecord = &inputRecord;
+    }
+    advisePageCache(recordNumber);
+    loadedRecord       = recordNumber;
+    loadedRecordFailed = loaded == false;
+    if (loaded == false) {
+      std::cerr << "[WARNING] record " << recordNumber << " at position "
+                << readerEventIndex.getPosition(recordNumber) << " can not be read" << std::endl;
+      currentRecord = &inputRecord;
+      failedRecords++;
+    }
+    return loaded;
+  }
+
+  /**
+   * Loads the record of the current event of the index, unless it is the
+   * record already loaded. Settings that change how records are read
+   * (prefetch, banks, cache...) forget the loaded record, so it is read
+   * again even if the index did not move to another record. Returns
+   * false if the record can not be read.
+   */
+  bool reader::loadCurrentRecord() {
+    int recordNumber = readerEventIndex.getRecordNumber();
+    if (recordNumber < 0)
+      return false;
+    if (recordNumber != loadedRecord)
+      return loadRecord(recordNumber);
+    return loadedRecordFailed == false;
   }
 
   /**
@@ -61,7 +444,11 @@ namespace hipo {
 
     std::vector<char> headerBuffer;
     headerBuffer.resize(80);
-    inputStream.read(&headerBuffer[0], 80);
+    if (mappedBuffer != NULL) {
+      std::memcpy(&headerBuffer[0], mappedBuffer, 80);
+    } else {
+      inputStream.read(&headerBuffer[0], 80);
+    }
 
     header.uniqueid     = *(reinterpret_cast<int*>(&headerBuffer[0]));
     header.filenumber   = *(reinterpret_cast<int*>(&headerBuffer[4]));
@@ -96,14 +483,20 @@ namespace hipo {
   }
 
   void reader::readIndex() {
-    inputRecord.readRecord(inputStream, header.trailerPosition, 0);
+    readerEventIndex.clear();
+    if (readRecord(inputRecord, header.trailerPosition) == false) {
+      std::cerr << "---> error : can not read the record index of the file" << std::endl;
+      return;
+    }
     hipo::event event;
     inputRecord.readHipoEvent(event, 0);
     hipo::structure base;
     event.getStructure(base, 32111, 1);
-    readerEventIndex.clear();
     int rows = base.getSize() / 32;
 
+    std::vector<bool> accepted(rows, true);
+    readRecordStatistics(event, accepted);
+
     for (int i = 0; i < rows; i++) {
       long position = base.getLongAt(i * 8);
       int  length   = base.getIntAt(rows * 8 + i * 4);
@@ -111,14 +504,18 @@ namespace hipo {
       long uid1     = base.getLongAt(rows * 16 + i * 8);
       long uid2     = base.getLongAt(rows * 24 + i * 8);
 
+      if (accepted[i] == false)
+        continue;
       if (tagsToRead.size() == 0) {
         readerEventIndex.addPosition(position);
+        readerEventIndex.addLength(length);
         readerEventIndex.addSize(entries);
       } else {
         for (auto& tag : tagsToRead) {
           if (tag == uid1) {
             readerEventIndex.addSize(entries);
             readerEventIndex.addPosition(position);
+            readerEventIndex.addLength(length);
           }
         }
       }
@@ -127,33 +524,119 @@ namespace hipo {
     readerEventIndex.rewind();
   }
 
+  /**
+   * Skips whole records where the minimum and maximum of the statistic
+   * (see writer::addStatistics) do not overlap [min,max]. All events of
+   * the remaining records are read, so the selection still has to be
+   * applied to the events. A column name "" is the number of rows of the
+   * bank, e.g. addFilter("REC::Particle", "", 2, INFINITY) skips records
+   * without any event with two or more particles. Filters on statistics
+   * that are not in the file are ignored. Set before open().
+   */
+  void reader::addFilter(const std::string& bank, const std::string& column, double min,
+                         double max) {
+    recordFilters.push_back({bank, column, min, max});
+  }
+
+  /**
+   * Applies the filters to the record statistics stored with the trailer
+   * index, records that do not pass are marked in accepted.
+   */
+  void reader::readRecordStatistics(hipo::event& indexEvent, std::vector<bool>& accepted) {
+    if (recordFilters.size() == 0)
+      return;
+    hipo::structure list;
+    indexEvent.getStructure(list, 32111, 3);
+    std::vector<std::string> names;
+    if (list.getSize() > 0) {
+      std::stringstream stream(list.getStringAt(0));
+      std::string       name;
+      while (std::getline(stream, name))
+        names.push_back(name);
+    }
+
+    hipo::schema statisticsSchema("file::statistics", 32111, 2);
+    statisticsSchema.parse("record/I,statistic/I,min/D,max/D");
+    hipo::bank statistics(statisticsSchema);
+    indexEvent.getStructure(statistics);
+
+    for (auto& filter : recordFilters) {
+      std::string name      = filter.bank + "/" + filter.column;
+      int         statistic = std::find(names.begin(), names.end(), name) - names.begin();
+      if (statistic == (int)names.size()) {
+        std::cerr << "[WARNING] no statistics for [" << name << "] in the file, filter ignored"
+                  << std::endl;
+        continue;
+      }
+      for (int row = 0; row < statistics.getRows(); row++) {
+        int record = statistics.getInt("record", row);
+        if (statistics.getInt("statistic", row) != statistic || record < 0 ||
+            record >= (int)accepted.size())
+          continue;
+        if (statistics.getDouble("max", row) < filter.min ||
+            statistics.getDouble("min", row) > filter.max)
+          accepted[record] = false;
+      }
+    }
+  }
+
   bool reader::hasNext() { return readerEventIndex.canAdvance(); }
 
+  /**
+   * Moves to the next event and reads it. Records that can not be read
+   * are skipped (see next()). Returns false if there is no readable
+   * event left, the event is then left unchanged.
+   */
   bool reader::next(hipo::event& dataevent) {
-    int recordNumber = readerEventIndex.getRecordNumber();
-    readerEventIndex.advance();
-    int recordToBeRead = readerEventIndex.getRecordNumber();
-    if (recordToBeRead != recordNumber) {
-      long position = readerEventIndex.getPosition(recordToBeRead);
-      inputRecord.readRecord(inputStream, position, 0);
-      /*printf(" record changed from %d to %d at event %d total event # %d\n",
-        recordNumber, recordToBeRead,readerEventIndex.getEventNumber(),
-        readerEventIndex.getMaxEvents());*/
-    }
+    if (next() == false)
+      return false;
     int eventNumberInRecord = readerEventIndex.getRecordEventNumber();
-    inputRecord.readHipoEvent(dataevent, eventNumberInRecord);
+    currentRecord->readHipoEvent(dataevent, eventNumberInRecord);
+    return true;
+  }
+
+  /**
+   * Moves the reader to the event with given number (counted from 0 over
+   * all records read). Only the record containing the event is read, and
+   * only if it is not the current record. Afterwards read() returns this
+   * event and next() continues with the following one. Returns false if
+   * the event number is out of range or its record can not be read.
+   */
+  bool reader::gotoEvent(long eventNumber) {
+    if (readerEventIndex.gotoEvent(eventNumber) == false)
+      return false;
+    return loadCurrentRecord();
+  }
+
+  bool reader::readEvent(long eventNumber, hipo::event& dataevent) {
+    if (gotoEvent(eventNumber) == false)
+      return false;
+    read(dataevent);
     return true;
   }
 
   void reader::read(hipo::event& dataevent) {
+    if (loadCurrentRecord() == false)
+      return;
     int eventNumberInRecord = readerEventIndex.getRecordEventNumber();
-    inputRecord.readHipoEvent(dataevent, eventNumberInRecord);
+    currentRecord->readHipoEvent(dataevent, eventNumberInRecord);
+  }
+
+  /**
+   * Points the event view to the current event in the record buffer,
+   * the view is valid until the reader moves to another record.
+   */
+  void reader::read(hipo::eventView& dataevent) {
+    if (loadCurrentRecord() == false)
+      return;
+    int eventNumberInRecord = readerEventIndex.getRecordEventNumber();
+    currentRecord->readHipoEvent(dataevent, eventNumberInRecord);
   }
 
   void reader::readDictionary(hipo::dictionary& dict) {
     long         position = header.headerLength * 4;
     hipo::record dictRecord;
-    dictRecord.readRecord(inputStream, position, 0);
+    readRecord(dictRecord, position);
     int nevents = dictRecord.getEventCount();
 
     hipo::structure schemaStructure;
@@ -161,7 +644,33 @@ namespace hipo {
     for (int i = 0; i < nevents; i++) {
       dictRecord.readHipoEvent(event, i);
       event.getStructure(schemaStructure, 120, 2);
-      dict.parse(schemaStructure.getStringAt(0).c_str());
+      if (schemaStructure.getSize() > 0)
+        dict.parse(schemaStructure.getStringAt(0).c_str());
+    }
+  }
+
+  /**
+   * Loads the LZ4 dictionary stored in the file user header (structure
+   * 120/10 in the schema events), if the file was written with one. It
+   * is needed to decompress records of type lz4dict.
+   */
+  void reader::readCompressionDictionary() {
+    long         position = header.headerLength * 4;
+    hipo::record dictRecord;
+    readRecord(dictRecord, position);
+    int nevents = dictRecord.getEventCount();
+
+    hipo::structure dictStructure;
+    hipo::event     event;
+    for (int i = 0; i < nevents; i++) {
+      dictRecord.readHipoEvent(event, i);
+      event.getStructure(dictStructure, 120, 10);
+      if (dictStructure.getSize() > 0) {
+        // binary data, getStringAt() would stop at the first zero byte
+        dictionaryCodec = codecRegistry::create(kCompressionLZ4Dict);
+        dictionaryCodec->setDictionary(dictStructure.getAddress() + 8, dictStructure.getSize());
+        return;
+      }
     }
   }
 
@@ -171,15 +680,24 @@ namespace hipo {
     return dict;
   }
 
+  /**
+   * Moves to the next event and loads its record. When a record can not
+   * be read its events are skipped and the reader moves on to the first
+   * event of the next record, the records skipped are counted by
+   * getFailedRecords(). Returns false if there is no readable event left,
+   * the reader is then at the last event (hasNext() is false).
+   */
   bool reader::next() {
     if (readerEventIndex.canAdvance() == false)
       return false;
-    int recordNumber = readerEventIndex.getRecordNumber();
     readerEventIndex.advance();
-    int recordToBeRead = readerEventIndex.getRecordNumber();
-    if (recordToBeRead != recordNumber) {
-      long position = readerEventIndex.getPosition(recordToBeRead);
-      inputRecord.readRecord(inputStream, position, 0);
+    while (loadCurrentRecord() == false) {
+      int nextRecord = readerEventIndex.getRecordNumber() + 1;
+      if (nextRecord >= readerEventIndex.getMaxRecords() ||
+          readerEventIndex.gotoEvent(readerEventIndex.getFirstEvent(nextRecord)) == false) {
+        readerEventIndex.gotoEvent(readerEventIndex.getMaxEvents() - 1);
+        return false;
+      }
     }
     return true;
   }
@@ -193,7 +711,7 @@ namespace hipo {
       recordEvents.push_back(0);
       recordEvents.push_back(size);
     } else {
-      int cz = recordEvents[recordEvents.size() - 1] + size;
+      long cz = recordEvents[recordEvents.size() - 1] + size;
       recordEvents.push_back(cz);
     }
   }
@@ -218,7 +736,31 @@ namespace hipo {
     return true;
   }
 
-  int readerIndex::getMaxEvents() {
+  /**
+   * Sets the current event to the given event number, the record
+   * containing it is found by binary search in the cumulative
+   * event counts.
+   */
+  bool readerIndex::gotoEvent(long eventNumber) {
+    if (eventNumber < 0 || eventNumber >= getMaxEvents())
+      return false;
+    currentRecord      = findRecord(eventNumber);
+    currentEvent       = eventNumber;
+    currentRecordEvent = eventNumber - recordEvents[currentRecord];
+    return true;
+  }
+
+  /**
+   * Returns the number of the record containing the given event, the
+   * event number must be in range. Does not change the current event.
+   */
+  int readerIndex::findRecord(long eventNumber) const {
+    std::vector<long>::const_iterator it =
+        std::upper_bound(recordEvents.begin(), recordEvents.end(), eventNumber);
+    return (it - recordEvents.begin()) - 1;
+  }
+
+  long readerIndex::getMaxEvents() const {
     if (recordEvents.size() == 0)
       return 0;
     return recordEvents[recordEvents.size() - 1];
@@ -5,37 +5,41 @@
  */
 
 #include "hipo4/record.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <unistd.h>
 //#include "hipoexceptions.h"
 
-#ifdef __LZ4__
-#include <lz4.h>
-#endif
-
 namespace hipo {
 
+  const int record::columnarBit;
+  const int record::columnarHeaderKey;
+  const int record::directAlignment;
+
   record::record() {}
 
   record::~record() {}
 
   /**
+   * decodes the record header from the given buffer (at least 56 bytes).
+   * The endianness of the record is determined from the magic word and
+   * all header words are swapped if needed.
    */
-  void record::readRecord(std::ifstream& stream, long position, int dataOffset) {
-
-    recordHeaderBuffer.resize(80);
-    stream.seekg(position, std::ios::beg);
-
-    stream.read((char*)&recordHeaderBuffer[0], 80);
-    if (recordHeader.signatureString == 0xc0da0100)
-      recordHeader.dataEndianness = 0;
-    recordHeader.recordLength     = *(reinterpret_cast<int*>(&recordHeaderBuffer[0]));
-    recordHeader.headerLength     = *(reinterpret_cast<int*>(&recordHeaderBuffer[8]));
-    recordHeader.numberOfEvents   = *(reinterpret_cast<int*>(&recordHeaderBuffer[12]));
-    recordHeader.bitInfo          = *(reinterpret_cast<int*>(&recordHeaderBuffer[20]));
-    recordHeader.signatureString  = *(reinterpret_cast<int*>(&recordHeaderBuffer[28]));
-    recordHeader.recordDataLength = *(reinterpret_cast<int*>(&recordHeaderBuffer[32]));
-    recordHeader.userHeaderLength = *(reinterpret_cast<int*>(&recordHeaderBuffer[24]));
-    int compressedWord            = *(reinterpret_cast<int*>(&recordHeaderBuffer[36]));
-
+  void record::readRecordHeader(const char* buffer) {
+    recordHeader.recordLength     = *(reinterpret_cast<const int*>(&buffer[0]));
+    recordHeader.headerLength     = *(reinterpret_cast<const int*>(&buffer[8]));
+    recordHeader.numberOfEvents   = *(reinterpret_cast<const int*>(&buffer[12]));
+    recordHeader.bitInfo          = *(reinterpret_cast<const int*>(&buffer[20]));
+    recordHeader.signatureString  = *(reinterpret_cast<const int*>(&buffer[28]));
+    recordHeader.recordDataLength = *(reinterpret_cast<const int*>(&buffer[32]));
+    recordHeader.userHeaderLength = *(reinterpret_cast<const int*>(&buffer[24]));
+    int compressedWord            = *(reinterpret_cast<const int*>(&buffer[36]));
+
+    recordHeader.dataEndianness = 0;
     if (recordHeader.signatureString == 0x0001dac0) {
       recordHeader.dataEndianness   = 1;
       recordHeader.recordLength     = __builtin_bswap32(recordHeader.recordLength);
@@ -47,97 +51,237 @@ namespace hipo {
       compressedWord                = __builtin_bswap32(compressedWord);
     }
 
-    int compressedDataLengthPadding = (recordHeader.bitInfo >> 24) & 0x00000003;
-    int headerLengthBytes           = recordHeader.headerLength * 4;
-    int dataBufferLengthBytes       = recordHeader.recordLength * 4 - headerLengthBytes;
-
+    recordHeader.compressedLengthPadding    = (recordHeader.bitInfo >> 24) & 0x00000003;
     recordHeader.userHeaderLengthPadding    = (recordHeader.bitInfo >> 20) & 0x00000003;
     recordHeader.recordDataLengthCompressed = compressedWord & 0x0FFFFFFF;
     recordHeader.compressionType            = (compressedWord >> 28) & 0x0000000F;
     recordHeader.indexDataLength            = 4 * recordHeader.numberOfEvents;
+  }
 
-    if (dataBufferLengthBytes > recordCompressedBuffer.size()) {
-      int newSize = dataBufferLengthBytes + 5 * 1024;
-      recordCompressedBuffer.resize(newSize);
+  /**
+   * converting index array from lengths of each buffer in the
+   * record to relative positions in the record stream. The record
+   * data is left untouched, so it can point into read-only memory.
+   */
+  void record::readRecordIndex() {
+    recordEventPositions.resize(recordHeader.numberOfEvents);
+    int eventPosition = 0;
+    for (int i = 0; i < recordHeader.numberOfEvents; i++) {
+      int size = *(reinterpret_cast<const int*>(&recordData[i * 4]));
+      if (recordHeader.dataEndianness == 1)
+        size = __builtin_bswap32(size);
+      eventPosition += size;
+      recordEventPositions[i] = eventPosition;
     }
+  }
 
-    long dataposition = position + headerLengthBytes;
-
-    stream.seekg(dataposition, std::ios::beg);
-
-    stream.read((&recordCompressedBuffer[0]), dataBufferLengthBytes);
+  /**
+   * reverses the column prefilters of the record (see prefilter.h). The
+   * events are decoded in place, so data that is not in the record buffer
+   * (not compressed, or memory mapped) is copied there first.
+   */
+  void record::removePrefilter() {
+    int dataLength = getDataLength();
+    if (recordBuffer.size() == 0 || recordData != &recordBuffer[0]) {
+      if (recordBuffer.size() < dataLength)
+        recordBuffer.resize(dataLength + 1024);
+      memcpy(&recordBuffer[0], recordData, dataLength);
+      recordData = &recordBuffer[0];
+    }
+    char* data = &recordBuffer[0];
+    recordPrefilter.decode(data + getDataOffset(), recordHeader.recordDataLength,
+                           data + recordHeader.indexDataLength, recordHeader.userHeaderLength);
+  }
 
-    int decompressedLength = recordHeader.indexDataLength + recordHeader.userHeaderLength +
-                             recordHeader.userHeaderLengthPadding + recordHeader.recordDataLength;
+  /**
+   * puts the events of a columnar record back together from the chunks of
+   * the selected structures (all if no filter is set), the other chunks
+   * are not decompressed. The result is a regular record in the record
+   * buffer, with an empty user header. Returns false if the chunk table
+   * does not match the record or a chunk fails to decompress.
+   */
+  bool record::readColumns() {
+    const char* table     = recordData + recordHeader.indexDataLength;
+    const char* chunkData = recordData + getDataOffset();
+    int         nchunks   = *(reinterpret_cast<const int*>(table));
+    int         nevents   = recordHeader.numberOfEvents;
+    if (nchunks < 0 || nevents < 0 || 4 + 16L * nchunks > recordHeader.userHeaderLength) {
+      std::cerr << "---> error : column chunk table does not fit in the record" << std::endl;
+      return false;
+    }
 
-    if (recordBuffer.size() < decompressedLength) {
-      recordBuffer.resize(decompressedLength + 1024);
+    // decompress the selected chunks one after the other
+    std::vector<int> chunks;
+    std::vector<int> chunkOffsets;
+    std::vector<int> chunkSizes;
+    int              headerChunk  = -1;
+    long             totalSize    = 0;
+    long             chunksLength = 0;
+    for (int c = 0; c < nchunks; c++) {
+      int key              = *(reinterpret_cast<const int*>(table + 4 + c * 16));
+      int chunkCompressed  = *(reinterpret_cast<const int*>(table + 4 + c * 16 + 8));
+      int uncompressedSize = *(reinterpret_cast<const int*>(table + 4 + c * 16 + 12));
+      int minimumSize      = (key == columnarHeaderKey) ? 16 * nevents : 4 * nevents;
+      if (chunkCompressed < 0 || uncompressedSize < minimumSize) {
+        std::cerr << "---> error : column chunk " << c << " has a wrong size" << std::endl;
+        return false;
+      }
+      chunksLength += chunkCompressed;
+      if (key == columnarHeaderKey) {
+        headerChunk = chunks.size();
+      } else if (structureFilter.size() > 0 &&
+                 std::find(structureFilter.begin(), structureFilter.end(), key) ==
+                     structureFilter.end()) {
+        continue;
+      }
+      chunks.push_back(c);
+      chunkOffsets.push_back(totalSize);
+      chunkSizes.push_back(uncompressedSize);
+      totalSize += uncompressedSize;
+      if (totalSize > std::numeric_limits<int>::max()) {
+        std::cerr << "---> error : column chunks are too large" << std::endl;
+        return false;
+      }
+    }
+    if (chunksLength > recordHeader.recordDataLength) {
+      std::cerr << "---> error : column chunks do not fit in the record" << std::endl;
+      return false;
+    }
+    if (columnBuffer.size() < (size_t)totalSize)
+      columnBuffer.resize(totalSize + 1024);
+
+    int position = 0;
+    int selected = 0;
+    for (int c = 0; c < nchunks; c++) {
+      int type             = *(reinterpret_cast<const int*>(table + 4 + c * 16 + 4));
+      int compressedSize   = *(reinterpret_cast<const int*>(table + 4 + c * 16 + 8));
+      int uncompressedSize = *(reinterpret_cast<const int*>(table + 4 + c * 16 + 12));
+      if (selected < (int)chunks.size() && chunks[selected] == c) {
+        char*        dest       = &columnBuffer[chunkOffsets[selected]];
+        const codec* chunkCodec = getCodec(type);
+        int          unc_result = -1;
+        if (chunkCodec != NULL)
+          unc_result = chunkCodec->decompress(chunkData + position, dest, compressedSize,
+                                              uncompressedSize);
+        if (unc_result != uncompressedSize) {
+          std::cerr << "---> error : failed to decompress column chunk " << c << std::endl;
+          return false;
+        }
+        selected++;
+      }
+      position += compressedSize;
     }
 
-    if (recordHeader.compressionType == 0) {
-      memcpy((&recordBuffer[0]), (&recordCompressedBuffer[0]), decompressedLength);
-    } else {
-      int unc_result =
-          getUncompressed((&recordCompressedBuffer[0]), (&recordBuffer[0]),
-                          dataBufferLengthBytes - compressedDataLengthPadding, decompressedLength);
+    // event sizes, then the events : header followed by the structures
+    // of every selected chunk, in chunk order. The structure lengths of
+    // every chunk must add up to its size.
+    long dataSize = 16L * nevents;
+    for (int s = 0; s < (int)chunks.size(); s++) {
+      if (s == headerChunk)
+        continue;
+      const int* lengths = reinterpret_cast<const int*>(&columnBuffer[chunkOffsets[s]]);
+      long       cursor  = 4L * nevents;
+      for (int e = 0; e < nevents; e++) {
+        if (lengths[e] < 0 || cursor + lengths[e] > chunkSizes[s]) {
+          std::cerr << "---> error : column chunk " << chunks[s] << " is shorter than its events"
+                    << std::endl;
+          return false;
+        }
+        cursor += lengths[e];
+      }
+      dataSize += cursor - 4L * nevents;
+    }
+    if (4L * nevents + dataSize > std::numeric_limits<int>::max()) {
+      std::cerr << "---> error : columnar record is too large" << std::endl;
+      return false;
+    }
+    if (recordBuffer.size() < (size_t)(4 * nevents + dataSize))
+      recordBuffer.resize(4 * nevents + dataSize + 1024);
+
+    std::vector<int> cursors(chunks.size(), 4 * nevents);
+    char*            index  = &recordBuffer[0];
+    char*            output = &recordBuffer[4 * nevents];
+    for (int e = 0; e < nevents; e++) {
+      char* event = output;
+      if (headerChunk >= 0)
+        memcpy(output, &columnBuffer[chunkOffsets[headerChunk] + e * 16], 16);
+      output += 16;
+      for (int s = 0; s < (int)chunks.size(); s++) {
+        if (s == headerChunk)
+          continue;
+        const char* chunk  = &columnBuffer[chunkOffsets[s]];
+        int         length = *(reinterpret_cast<const int*>(chunk + e * 4));
+        memcpy(output, chunk + cursors[s], length);
+        cursors[s] += length;
+        output += length;
+      }
+      int eventSize                            = output - event;
+      *(reinterpret_cast<int*>(event + 4))     = eventSize;
+      *(reinterpret_cast<int*>(index + e * 4)) = eventSize;
     }
 
-    /**
-     * converting index array from lengths of each buffer in the
-     * record to relative positions in the record stream.
-     */
+    recordHeader.userHeaderLength        = 0;
+    recordHeader.userHeaderLengthPadding = 0;
+    recordHeader.recordDataLength        = dataSize;
+    recordData                           = &recordBuffer[0];
+    return true;
+  }
 
-    int eventPosition = 0;
-    for (int i = 0; i < recordHeader.numberOfEvents; i++) {
-      int* ptr  = reinterpret_cast<int*>(&recordBuffer[i * 4]);
-      int  size = *ptr;
-      if (recordHeader.dataEndianness == 1)
-        size = __builtin_bswap32(size);
-      eventPosition += size;
-      *ptr = eventPosition;
-    }
+  /**
+   * returns the length of the uncompressed record data, including the
+   * index array and the user header.
+   */
+  int record::getDataLength() {
+    return recordHeader.indexDataLength + recordHeader.userHeaderLength +
+           recordHeader.userHeaderLengthPadding + recordHeader.recordDataLength;
   }
 
-  bool record::readRecord(std::ifstream& stream, long position, int dataOffset, long inputSize) {
-    if ((position + 80) >= inputSize)
-      return false;
+  /**
+   * returns the offset of the first event in the uncompressed record data.
+   */
+  int record::getDataOffset() {
+    return recordHeader.indexDataLength + recordHeader.userHeaderLength +
+           recordHeader.userHeaderLengthPadding;
+  }
+
+  /**
+   */
+  void record::readRecord(std::ifstream& stream, long position, int dataOffset) {
 
     recordHeaderBuffer.resize(80);
     stream.seekg(position, std::ios::beg);
 
     stream.read((char*)&recordHeaderBuffer[0], 80);
-    recordHeader.recordLength     = *(reinterpret_cast<int*>(&recordHeaderBuffer[0]));
-    recordHeader.headerLength     = *(reinterpret_cast<int*>(&recordHeaderBuffer[8]));
-    recordHeader.numberOfEvents   = *(reinterpret_cast<int*>(&recordHeaderBuffer[12]));
-    recordHeader.bitInfo          = *(reinterpret_cast<int*>(&recordHeaderBuffer[20]));
-    recordHeader.signatureString  = *(reinterpret_cast<int*>(&recordHeaderBuffer[28]));
-    recordHeader.recordDataLength = *(reinterpret_cast<int*>(&recordHeaderBuffer[32]));
-    recordHeader.userHeaderLength = *(reinterpret_cast<int*>(&recordHeaderBuffer[24]));
-    int compressedWord            = *(reinterpret_cast<int*>(&recordHeaderBuffer[36]));
-
-    if (recordHeader.signatureString == 0xc0da0100)
-      recordHeader.dataEndianness = 0;
-    if (recordHeader.signatureString == 0x0001dac0)
-      recordHeader.dataEndianness = 1;
+    readRecordHeader(&recordHeaderBuffer[0]);
 
-    if (recordHeader.signatureString == 0x0001dac0) {
-      recordHeader.recordLength     = __builtin_bswap32(recordHeader.recordLength);
-      recordHeader.headerLength     = __builtin_bswap32(recordHeader.headerLength);
-      recordHeader.numberOfEvents   = __builtin_bswap32(recordHeader.numberOfEvents);
-      recordHeader.recordDataLength = __builtin_bswap32(recordHeader.recordDataLength);
-      recordHeader.userHeaderLength = __builtin_bswap32(recordHeader.userHeaderLength);
-      recordHeader.bitInfo          = __builtin_bswap32(recordHeader.bitInfo);
-      compressedWord                = __builtin_bswap32(compressedWord);
+    int headerLengthBytes     = recordHeader.headerLength * 4;
+    int dataBufferLengthBytes = recordHeader.recordLength * 4 - headerLengthBytes;
+
+    if (dataBufferLengthBytes > recordCompressedBuffer.size()) {
+      int newSize = dataBufferLengthBytes + 5 * 1024;
+      recordCompressedBuffer.resize(newSize);
     }
 
-    int compressedDataLengthPadding = (recordHeader.bitInfo >> 24) & 0x00000003;
-    int headerLengthBytes           = recordHeader.headerLength * 4;
-    int dataBufferLengthBytes       = recordHeader.recordLength * 4 - headerLengthBytes;
+    long dataposition = position + headerLengthBytes;
 
-    recordHeader.userHeaderLengthPadding    = (recordHeader.bitInfo >> 20) & 0x00000003;
-    recordHeader.recordDataLengthCompressed = compressedWord & 0x0FFFFFFF;
-    recordHeader.compressionType            = (compressedWord >> 28) & 0x0000000F;
-    recordHeader.indexDataLength            = 4 * recordHeader.numberOfEvents;
+    stream.seekg(dataposition, std::ios::beg);
+
+    stream.read((&recordCompressedBuffer[0]), dataBufferLengthBytes);
+    decodeRecord(&recordCompressedBuffer[0], dataBufferLengthBytes);
+  }
+
+  bool record::readRecord(std::ifstream& stream, long position, int dataOffset, long inputSize) {
+    if ((position + 80) >= inputSize)
+      return failRecord();
+
+    recordHeaderBuffer.resize(80);
+    stream.seekg(position, std::ios::beg);
+
+    stream.read((char*)&recordHeaderBuffer[0], 80);
+    readRecordHeader(&recordHeaderBuffer[0]);
+
+    int headerLengthBytes     = recordHeader.headerLength * 4;
+    int dataBufferLengthBytes = recordHeader.recordLength * 4 - headerLengthBytes;
 
     if (dataBufferLengthBytes > recordCompressedBuffer.size()) {
       int newSize = dataBufferLengthBytes + 5 * 1024;
@@ -151,39 +295,211 @@ namespace hipo {
     if (position + dataBufferLengthBytes + recordHeader.headerLength > inputSize) {
       std::cerr << "**** warning : record at position " << position << " is incomplete."
                 << std::endl;
-      return false;
+      return failRecord();
     }
     stream.read((&recordCompressedBuffer[0]), dataBufferLengthBytes);
+    if (stream.gcount() != dataBufferLengthBytes) {
+      std::cerr << "**** warning : failed to read record at position " << position << std::endl;
+      stream.clear();
+      return failRecord();
+    }
+    return decodeRecord(&recordCompressedBuffer[0], dataBufferLengthBytes);
+  }
+
+  /**
+   * reads count bytes at given file offset, retrying short reads.
+   * Returns false at the end of the file or on error.
+   */
+  static bool preadFully(int fd, char* dest, long count, long offset) {
+    while (count > 0) {
+      ssize_t n = ::pread(fd, dest, count, offset);
+      if (n <= 0)
+        return false;
+      dest += n;
+      offset += n;
+      count -= n;
+    }
+    return true;
+  }
+
+  /**
+   * reads the record at given position from a file descriptor with
+   * pread(), which does not move a shared file offset, so several
+   * threads can read records of the same descriptor concurrently
+   * (each with its own record). Returns false if the record is
+   * incomplete or can not be read.
+   */
+  bool record::readRecord(int fd, long position, long inputSize) {
+    if ((position + 56) >= inputSize)
+      return failRecord();
+
+    recordHeaderBuffer.resize(80);
+    if (preadFully(fd, &recordHeaderBuffer[0], 56, position) == false)
+      return failRecord();
+    readRecordHeader(&recordHeaderBuffer[0]);
 
-    int decompressedLength = recordHeader.indexDataLength + recordHeader.userHeaderLength +
-                             recordHeader.userHeaderLengthPadding + recordHeader.recordDataLength;
+    int headerLengthBytes     = recordHeader.headerLength * 4;
+    int dataBufferLengthBytes = recordHeader.recordLength * 4 - headerLengthBytes;
 
-    if (recordBuffer.size() < decompressedLength) {
-      recordBuffer.resize(decompressedLength + 1024);
+    if (position + headerLengthBytes + dataBufferLengthBytes > inputSize) {
+      std::cerr << "**** warning : record at position " << position << " is incomplete."
+                << std::endl;
+      return failRecord();
+    }
+    if (dataBufferLengthBytes > recordCompressedBuffer.size()) {
+      int newSize = dataBufferLengthBytes + 5 * 1024;
+      recordCompressedBuffer.resize(newSize);
+    }
+    if (preadFully(fd, &recordCompressedBuffer[0], dataBufferLengthBytes,
+                   position + headerLengthBytes) == false) {
+      std::cerr << "**** warning : failed to read record at position " << position << std::endl;
+      return failRecord();
     }
+    return decodeRecord(&recordCompressedBuffer[0], dataBufferLengthBytes);
+  }
 
-    if (recordHeader.compressionType == 0) {
-      memcpy((&recordBuffer[0]), (&recordCompressedBuffer[0]), decompressedLength);
-    } else {
-      int unc_result =
-          getUncompressed((&recordCompressedBuffer[0]), (&recordBuffer[0]),
-                          dataBufferLengthBytes - compressedDataLengthPadding, decompressedLength);
+  /**
+   * reads length bytes at the block aligned offset into the aligned
+   * buffer (length is a multiple of the alignment). Returns the number
+   * of bytes read, which is less than length at the end of the file.
+   */
+  long record::readAligned(int fd, long offset, long length) {
+    if (length > directBufferSize) {
+      void* ptr = NULL;
+      if (posix_memalign(&ptr, directAlignment, length + directAlignment) != 0)
+        return 0;
+      directBuffer.reset(reinterpret_cast<char*>(ptr));
+      directBufferSize = length + directAlignment;
+    }
+    long done = 0;
+    while (done < length) {
+      ssize_t n = ::pread(fd, directBuffer.get() + done, length - done, offset + done);
+      if (n <= 0)
+        break;
+      done += n;
     }
+    return done;
+  }
 
-    int eventPosition = 0;
-    for (int i = 0; i < recordHeader.numberOfEvents; i++) {
-      int* ptr  = reinterpret_cast<int*>(&recordBuffer[i * 4]);
-      int  size = *ptr;
-      if (recordHeader.dataEndianness == 1)
-        size = __builtin_bswap32(size);
-      eventPosition += size;
-      *ptr = eventPosition;
+  /**
+   * Same as readRecord(fd, position, inputSize) for descriptors opened
+   * with O_DIRECT, which bypass the page cache. The blocks containing
+   * the record are read into a block aligned buffer and the record is
+   * decoded from there.
+   */
+  bool record::readRecordDirect(int fd, long position, long inputSize) {
+    if ((position + 56) >= inputSize)
+      return failRecord();
+    long start  = position - position % directAlignment;
+    long offset = position - start;
+    long length = (offset + 80 + directAlignment - 1) / directAlignment * directAlignment;
+    if (readAligned(fd, start, length) < offset + 56) {
+      std::cerr << "**** warning : failed to read record at position " << position << std::endl;
+      return failRecord();
+    }
+    readRecordHeader(directBuffer.get() + offset);
+
+    long recordBytes = recordHeader.recordLength * 4L;
+    if (position + recordBytes > inputSize) {
+      std::cerr << "**** warning : record at position " << position << " is incomplete."
+                << std::endl;
+      return failRecord();
+    }
+    length    = (offset + recordBytes + directAlignment - 1) / directAlignment * directAlignment;
+    long size = readAligned(fd, start, length);
+    return readRecord(directBuffer.get(), offset, size);
+  }
+
+  /**
+   * reads the record at given position from a memory mapped file of the
+   * given size. The record header and uncompressed payloads are used
+   * directly from the mapped memory without copying, compressed payloads
+   * are decompressed from the mapped memory into the record buffer.
+   * The mapped memory must stay valid while the record is in use.
+   */
+  bool record::readRecord(const char* buffer, long position, long bufferSize) {
+    if ((position + 80) >= bufferSize)
+      return failRecord();
+
+    readRecordHeader(&buffer[position]);
+
+    int headerLengthBytes     = recordHeader.headerLength * 4;
+    int dataBufferLengthBytes = recordHeader.recordLength * 4 - headerLengthBytes;
+
+    if (position + headerLengthBytes + dataBufferLengthBytes > bufferSize) {
+      std::cerr << "**** warning : record at position " << position << " is incomplete."
+                << std::endl;
+      return failRecord();
+    }
+
+    return decodeRecord(&buffer[position + headerLengthBytes], dataBufferLengthBytes);
+  }
+
+  /**
+   * decodes the record data that follows the record header, dataBuffer
+   * holds dataLength bytes (compressed, or not compressed and used in
+   * place). Returns false if the data is shorter than the record header
+   * says or does not decompress to the expected length, the record is
+   * then left empty (no events).
+   */
+  bool record::decodeRecord(const char* dataBuffer, int dataLength) {
+    int decompressedLength = getDataLength();
+
+    if (recordHeader.compressionType == 0) {
+      recordData = dataBuffer;
+      if (decompressedLength > dataLength) {
+        std::cerr << "---> error : record data is shorter than the record header length"
+                  << std::endl;
+        return failRecord();
+      }
+    } else {
+      if (recordBuffer.size() < decompressedLength) {
+        recordBuffer.resize(decompressedLength + 1024);
+      }
+      int unc_result = getUncompressed(dataBuffer, (&recordBuffer[0]),
+                                       dataLength - recordHeader.compressedLengthPadding,
+                                       decompressedLength);
+      if (unc_result != decompressedLength)
+        unc_result = getUncompressedTruncated(dataBuffer, (&recordBuffer[0]),
+                                              dataLength - recordHeader.compressedLengthPadding,
+                                              decompressedLength);
+      recordData     = &recordBuffer[0];
+      if (unc_result != decompressedLength) {
+        std::cerr << "---> error : failed to decompress record (" << unc_result << " of "
+                  << decompressedLength << " bytes)" << std::endl;
+        return failRecord();
+      }
     }
+    if ((recordHeader.bitInfo & columnarBit) != 0 && readColumns() == false)
+      return failRecord();
+    if ((recordHeader.bitInfo & prefilter::recordBit) != 0)
+      removePrefilter();
+    readRecordIndex();
     return true;
   }
 
+  /**
+   * empties the record after a failed read, so events of a record that
+   * could not be decoded are never read. Returns false.
+   */
+  bool record::failRecord() {
+    recordHeader.numberOfEvents = 0;
+    recordEventPositions.clear();
+    return false;
+  }
+
   int record::getRecordSizeCompressed() { return recordHeader.recordLength; }
 
+  /**
+   * Returns the memory (bytes) allocated by the buffers of the record,
+   * used to bound the size of the record cache.
+   */
+  long record::getMemorySize() {
+    return sizeof(record) + recordHeaderBuffer.capacity() + recordBuffer.capacity() +
+           recordCompressedBuffer.capacity() + columnBuffer.capacity() +
+           recordEventPositions.capacity() * sizeof(int) + directBufferSize;
+  }
+
   int record::getEventCount() { return recordHeader.numberOfEvents; }
 
   void record::readEvent(std::vector<char>& vec, int index) {}
@@ -191,12 +507,11 @@ namespace hipo {
   void record::getData(hipo::data& data, int index) {
     int first_position = 0;
     if (index > 0) {
-      first_position = *(reinterpret_cast<uint32_t*>(&recordBuffer[(index - 1) * 4]));
+      first_position = recordEventPositions[index - 1];
     }
-    int last_position = *(reinterpret_cast<uint32_t*>(&recordBuffer[index * 4]));
-    int offset        = recordHeader.indexDataLength + recordHeader.userHeaderLength +
-                 recordHeader.userHeaderLengthPadding;
-    data.setDataPtr(&recordBuffer[first_position + offset]);
+    int last_position = recordEventPositions[index];
+    int offset        = getDataOffset();
+    data.setDataPtr(&recordData[first_position + offset]);
     data.setDataSize(last_position - first_position);
     data.setDataOffset(first_position + offset);
   }
@@ -206,6 +521,12 @@ namespace hipo {
     getData(event_data, index);
     event.init(event_data.getDataPtr(), event_data.getDataSize());
   }
+
+  void record::readHipoEvent(hipo::eventView& event, int index) {
+    hipo::data event_data;
+    getData(event_data, index);
+    event.init(event_data.getDataPtr(), event_data.getDataSize());
+  }
   /**
    * prints the content of given buffer in HEX format. Used for debugging.
    */
@@ -220,37 +541,152 @@ namespace hipo {
   /**
    * decompresses the buffer given with pointed *data, into a destination array
    * provided. The arguments indicate the compressed data length (dataLength),
-   * and maximum decompressed length.
-   * returns the number of bytes that were decompressed by LZ4
+   * and maximum decompressed length. The codec is the one registered for
+   * the compression type of the current record header (or the one with
+   * the dictionary of the file for lz4dict records).
+   * returns the number of bytes that were decompressed
    */
   int record::getUncompressed(const char* data, char* dest, int dataLength,
                               int dataLengthUncompressed) {
-#ifdef __LZ4__
-    int result = LZ4_decompress_safe(data, dest, dataLength, dataLengthUncompressed);
-    return result;
-#else
-    std::cerr >> "LZ4 compression is not supported." << std::endl;
-    std::cerr >> "check if libz4 is installed on your system." << std::endl;
-    std::cerr >> "recompile the library with liblz4 installed." << std::endl;
-    return NULL;
-#endif
+    if ((recordHeader.bitInfo & blockBit) != 0)
+      return getUncompressedBlocks(data, dest, dataLength, dataLengthUncompressed);
+    const codec* recordCodec = getCodec(recordHeader.compressionType);
+    if (recordCodec == NULL)
+      return -1;
+    return recordCodec->decompress(data, dest, dataLength, dataLengthUncompressed);
+  }
+
+  /**
+   * decompresses a block compressed record (see record.h). The blocks are
+   * handed out to decompressionThreads threads (the calling one included)
+   * and written next to each other in dest. Returns the number of bytes
+   * decompressed, or -1 if the block table is corrupt or a block fails.
+   */
+  int record::getUncompressedBlocks(const char* data, char* dest, int dataLength,
+                                    int dataLengthUncompressed) {
+    int nblocks = (dataLength < 4) ? -1 : *(reinterpret_cast<const int*>(data));
+    if (nblocks < 0 || nblocks > (dataLength - 4L) / 12) {
+      std::cerr << "---> error : block table does not fit in the record" << std::endl;
+      return -1;
+    }
+    std::vector<int> sourceOffsets(nblocks);
+    std::vector<int> destOffsets(nblocks);
+    long             sourcePosition = 4 + nblocks * 12L;
+    long             destPosition   = 0;
+    for (int b = 0; b < nblocks; b++) {
+      int compressedSize   = *(reinterpret_cast<const int*>(data + 8 + b * 12));
+      int uncompressedSize = *(reinterpret_cast<const int*>(data + 12 + b * 12));
+      if (compressedSize < 0 || uncompressedSize < 0) {
+        std::cerr << "---> error : record block " << b << " has a wrong size" << std::endl;
+        return -1;
+      }
+      sourceOffsets[b] = sourcePosition;
+      destOffsets[b]   = destPosition;
+      sourcePosition += compressedSize;
+      destPosition += uncompressedSize;
+      if (sourcePosition > dataLength || destPosition > dataLengthUncompressed) {
+        std::cerr << "---> error : record block " << b << " does not fit in the record"
+                  << std::endl;
+        return -1;
+      }
+    }
+    if (destPosition != dataLengthUncompressed) {
+      std::cerr << "---> error : record blocks hold " << destPosition << " of "
+                << dataLengthUncompressed << " bytes" << std::endl;
+      return -1;
+    }
+
+    std::atomic<int>  nextBlock(0);
+    std::atomic<bool> failed(false);
+    auto              decompressBlocks = [&]() {
+      for (int b = nextBlock++; b < nblocks; b = nextBlock++) {
+        int          type             = *(reinterpret_cast<const int*>(data + 4 + b * 12));
+        int          compressedSize   = *(reinterpret_cast<const int*>(data + 8 + b * 12));
+        int          uncompressedSize = *(reinterpret_cast<const int*>(data + 12 + b * 12));
+        const codec* blockCodec       = getCodec(type);
+        if (blockCodec == NULL ||
+            blockCodec->decompress(data + sourceOffsets[b], dest + destOffsets[b],
+                                   compressedSize, uncompressedSize) != uncompressedSize)
+          failed = true;
+      }
+    };
+    int                      nthreads = std::min(decompressionThreads, nblocks);
+    std::vector<std::thread> workers;
+    for (int t = 1; t < nthreads; t++)
+      workers.push_back(std::thread(decompressBlocks));
+    decompressBlocks();
+    for (auto& worker : workers)
+      worker.join();
+
+    if (failed == true) {
+      std::cerr << "---> error : failed to decompress record block" << std::endl;
+      return -1;
+    }
+    return destPosition;
+  }
+
+  /**
+   * decompresses a LZ4 record written before the record length rounding
+   * was fixed. Those writers dropped the last bytes of the compressed data
+   * (up to 6), which are always literals in LZ4, so all but the last few
+   * bytes of the record decode. The record is accepted with a warning if
+   * at most truncatedBytes are missing and its event index matches the
+   * data length, the missing bytes are zeroed. Returns the number of bytes
+   * decompressed (the full length if accepted), or -1.
+   */
+  int record::getUncompressedTruncated(const char* data, char* dest, int dataLength,
+                                       int dataLengthUncompressed) {
+    const int truncatedBytes = 16;
+    if ((recordHeader.bitInfo & (blockBit | columnarBit)) != 0 ||
+        recordHeader.compressionType != kCompressionLZ4 || dataLength <= 0)
+      return -1;
+    int decoded = codecRegistry::get(kCompressionLZ4)->decompressPartial(data, dest, dataLength,
+                                                                         dataLengthUncompressed);
+    if (decoded < recordHeader.indexDataLength ||
+        decoded < dataLengthUncompressed - truncatedBytes)
+      return -1;
+
+    long eventsLength = 0;
+    for (int i = 0; i < recordHeader.numberOfEvents; i++) {
+      int size = *(reinterpret_cast<const int*>(&dest[i * 4]));
+      if (recordHeader.dataEndianness == 1)
+        size = __builtin_bswap32(size);
+      if (size < 0)
+        return -1;
+      eventsLength += size;
+    }
+    if (eventsLength != recordHeader.recordDataLength)
+      return -1;
+
+    std::cerr << "[WARNING] record is truncated (" << decoded << " of " << dataLengthUncompressed
+              << " bytes), its last event may be incomplete" << std::endl;
+    memset(dest + decoded, 0, dataLengthUncompressed - decoded);
+    return dataLengthUncompressed;
+  }
+
+  /**
+   * returns the codec for the compression type, the one with the
+   * dictionary of the file for lz4dict, or NULL if the type is unknown.
+   */
+  const codec* record::getCodec(int compressionType) {
+    const codec* typeCodec = codecRegistry::get(compressionType);
+    if (compressionType == kCompressionLZ4Dict && dictionaryCodec)
+      typeCodec = dictionaryCodec.get();
+    if (typeCodec == NULL)
+      std::cerr << "---> error : unknown compression type " << compressionType << std::endl;
+    return typeCodec;
   }
   /**
    * deompresses the content of given buffer ( *data), into a newly allocated
    * memory. User is responsible for free-ing the allocated memory.
    */
   char* record::getUncompressed(const char* data, int dataLength, int dataLengthUncompressed) {
-
-#ifdef __LZ4__
     char* output = (char*)malloc(dataLengthUncompressed);
-    int result = LZ4_decompress_safe(data, output, dataLength, dataLengthUncompressed);
+    if (getUncompressed(data, output, dataLength, dataLengthUncompressed) < 0) {
+      free(output);
+      return NULL;
+    }
     return output;
-#else
-    std::cerr >> "LZ4 compression is not supported." << std::endl;
-    std::cerr >> "check if libz4 is installed on your system." << std::endl;
-    std::cerr >> "recompile the library with liblz4 installed." << std::endl;
-    return NULL;
-#endif
   }
 
 } // namespace hipo
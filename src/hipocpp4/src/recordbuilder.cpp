@@ -5,10 +5,8 @@
  */
 
 #include "hipo4/recordbuilder.h"
-
-#ifdef __LZ4__
-#include <lz4.h>
-#endif
+#include "hipo4/record.h"
+#include <algorithm>
 
 namespace hipo {
 
@@ -20,6 +18,9 @@ namespace hipo {
 
     bufferIndexEntries   = 0;
     bufferEventsPosition = 0;
+    bufferEventsFiltered = false;
+    recordCodec          = codecRegistry::create(kCompressionLZ4);
+    minCompressionGain   = 0.0;
   }
 
   recordbuilder::recordbuilder(int maxEvents, int maxLength) {
@@ -29,6 +30,9 @@ namespace hipo {
     bufferRecord.resize(maxLength + 4 * maxEvents + 512 * 1024);
     bufferIndexEntries   = 0;
     bufferEventsPosition = 0;
+    bufferEventsFiltered = false;
+    recordCodec          = codecRegistry::create(kCompressionLZ4);
+    minCompressionGain   = 0.0;
   }
 
   bool recordbuilder::addEvent(hipo::event& evnt) {
@@ -50,12 +54,16 @@ namespace hipo {
   void recordbuilder::reset() {
     bufferIndexEntries   = 0;
     bufferEventsPosition = 0;
+    bufferEventsFiltered = false;
+    recordStatistics.clear();
   }
 
+  /**
+   * Returns the number of padding bytes needed to make the buffer a
+   * whole number of words.
+   */
   int recordbuilder::getRecordLengthRounding(int bufferSize) {
-    int nwords = bufferSize / 4;
-    int nbytes = 4 * nwords;
-    return (bufferSize - nbytes);
+    return (4 - bufferSize % 4) % 4;
   }
   /**
    * Returns number of events in the record.
@@ -81,13 +89,49 @@ namespace hipo {
   }
 
   void recordbuilder::build() {
+    if (useColumnar == true) {
+      buildColumnar();
+      return;
+    }
     int indexSize  = bufferIndexEntries * 4;
     int eventsSize = bufferEventsPosition;
+    // the events are filtered in place, only once if build() is repeated
+    if (bufferEventsFiltered == false) {
+      bufferLayout.clear();
+      if (usePrefilter == true)
+        recordPrefilter.encode(&bufferEvents[0], eventsSize, bufferLayout);
+      bufferEventsFiltered = true;
+    }
+    int layoutSize     = bufferLayout.size();
+    int layoutPadding  = getRecordLengthRounding(layoutSize);
+    int userHeaderSize = layoutSize + layoutPadding;
+    if (bufferData.size() < (size_t)(indexSize + userHeaderSize + eventsSize))
+      bufferData.resize(indexSize + userHeaderSize + eventsSize);
+    if (bufferRecord.size() < (size_t)(56 + indexSize + userHeaderSize + eventsSize + 4))
+      bufferRecord.resize(56 + indexSize + userHeaderSize + eventsSize + 4);
+
     memcpy(&bufferData[0], &bufferIndex[0], indexSize);
-    memcpy(&bufferData[indexSize], &bufferEvents[0], eventsSize);
-    int uncompressedSize           = indexSize + eventsSize;
-    int compressedSize             = compressRecord(uncompressedSize);
-    int rounding                   = getRecordLengthRounding(compressedSize);
+    if (layoutSize > 0) {
+      memcpy(&bufferData[indexSize], &bufferLayout[0], layoutSize);
+      memset(&bufferData[indexSize + layoutSize], 0, layoutPadding);
+    }
+    memcpy(&bufferData[indexSize + userHeaderSize], &bufferEvents[0], eventsSize);
+    int  uncompressedSize = indexSize + userHeaderSize + eventsSize;
+    int  compressionType  = recordCodec ? recordCodec->getType() : kCompressionNone;
+    int  compressedSize   = 0;
+    bool blocks           = blockSize > 0 && uncompressedSize > blockSize;
+    if (compressionType != kCompressionNone)
+      compressedSize = blocks ? compressBlocks(uncompressedSize) : compressRecord(uncompressedSize);
+    // store the record as it is if compression fails or gains too little
+    if (compressedSize <= 0 ||
+        compressedSize > (1.0 - minCompressionGain) * (double)uncompressedSize) {
+      memcpy(&bufferRecord[56], &bufferData[0], uncompressedSize);
+      compressedSize  = uncompressedSize;
+      compressionType = kCompressionNone;
+      blocks          = false;
+    }
+    int rounding = getRecordLengthRounding(compressedSize);
+    memset(&bufferRecord[56 + compressedSize], 0, rounding);
     int compressedSizeToWrite      = compressedSize + rounding;
     int compressedSizeToWriteWords = compressedSizeToWrite / 4;
     int recordLength               = compressedSizeToWrite / 4 + 14;
@@ -100,33 +144,188 @@ namespace hipo {
                           bufferIndexEntries); // (4) event count in the record
     hipo::utils::writeInt(&bufferRecord[0], 16,
                           bufferIndexEntries * 4); // (5) length of index array in bytes
-    int versionWord = (rounding << 24) | (4);
+    int versionWord = (rounding << 24) | (layoutPadding << 20) | (4);
+    if (layoutSize > 0)
+      versionWord |= prefilter::recordBit;
+    if (blocks == true)
+      versionWord |= record::blockBit;
     hipo::utils::writeInt(&bufferRecord[0], 20, versionWord); // (6) record version number
-    hipo::utils::writeInt(&bufferRecord[0], 24, 0);           // (7) user header length bytes
+    hipo::utils::writeInt(&bufferRecord[0], 24, layoutSize);  // (7) user header length bytes
     hipo::utils::writeInt(&bufferRecord[0], 28, 0xc0da0100);  // (8) magic word
     hipo::utils::writeInt(&bufferRecord[0], 32, eventsSize);  // (9) magic word
-    int compressionWord = (1 << 28) | (0x0FFFFFFF & compressedSizeToWriteWords);
+    int compressionWord = (compressionType << 28) | (0x0FFFFFFF & compressedSizeToWriteWords);
     hipo::utils::writeInt(&bufferRecord[0], 36, compressionWord);
-    hipo::utils::writeLong(&bufferRecord[0], 40, 0);
+    hipo::utils::writeLong(&bufferRecord[0], 40, userWordOne);
     hipo::utils::writeLong(&bufferRecord[0], 48, 0);
   }
 
-  int recordbuilder::compressRecord(int src_size) {
+  /**
+   * Builds a columnar record (see record.h). The structures of all events
+   * are sorted into one chunk per (group,item), in the order they first
+   * appear, and every chunk is compressed on its own. The event headers
+   * go to the first chunk. The column prefilter is not used with this
+   * layout.
+   */
+  void recordbuilder::buildColumnar() {
+    for (auto& lengths : columnLengths)
+      lengths.clear();
+    for (auto& data : columnData)
+      data.clear();
+    columnIndex.clear();
+    columnKeys.clear();
+
+    int nevents        = bufferIndexEntries;
+    int eventsPosition = 0;
+    int headerChunk    = columnKeys.size();
+    columnKeys.push_back(record::columnarHeaderKey);
+    if (columnData.size() < 1) {
+      columnData.resize(1);
+      columnLengths.resize(1);
+    }
+    for (int e = 0; e < nevents; e++) {
+      int         eventSize = *reinterpret_cast<int*>(&bufferIndex[e * 4]);
+      const char* event     = &bufferEvents[eventsPosition];
+      columnData[headerChunk].insert(columnData[headerChunk].end(), event, event + 16);
+      int offset = 16;
+      while (offset + 8 <= eventSize) {
+        int group  = *reinterpret_cast<const uint16_t*>(event + offset);
+        int item   = *reinterpret_cast<const uint8_t*>(event + offset + 2);
+        int length = *reinterpret_cast<const int*>(event + offset + 4) + 8;
+        if (length < 8 || offset + length > eventSize)
+          break;
+        int                          key   = (group << 8) | item;
+        int                          chunk = 0;
+        std::map<int, int>::iterator it    = columnIndex.find(key);
+        if (it == columnIndex.end()) {
+          chunk = addColumnChunk(key, nevents);
+        } else {
+          chunk = it->second;
+        }
+        columnLengths[chunk][e] += length;
+        columnData[chunk].insert(columnData[chunk].end(), event + offset, event + offset + length);
+        offset += length;
+      }
+      eventsPosition += eventSize;
+    }
+
+    int nchunks   = columnKeys.size();
+    int indexSize = nevents * 4;
+    int tableSize = 4 + nchunks * 16;
+    int position  = 56 + indexSize + tableSize;
+    if (bufferRecord.size() < (size_t)position)
+      bufferRecord.resize(position);
+    memcpy(&bufferRecord[56], &bufferIndex[0], indexSize);
+    hipo::utils::writeInt(&bufferRecord[0], 56 + indexSize, nchunks);
+
+    for (int c = 0; c < nchunks; c++) {
+      std::vector<char>& data        = columnData[c];
+      int                lengthsSize = (c == headerChunk) ? 0 : nevents * 4;
+      int                chunkSize   = lengthsSize + data.size();
+      if (columnScratch.size() < (size_t)chunkSize)
+        columnScratch.resize(chunkSize);
+      if (lengthsSize > 0)
+        memcpy(&columnScratch[0], &columnLengths[c][0], lengthsSize);
+      if (data.size() > 0)
+        memcpy(&columnScratch[lengthsSize], &data[0], data.size());
+
+      if (bufferRecord.size() < (size_t)(position + chunkSize + 4))
+        bufferRecord.resize(position + chunkSize + 4 + 512 * 1024);
+      int compressionType = recordCodec ? recordCodec->getType() : kCompressionNone;
+      int compressedSize  = 0;
+      if (compressionType != kCompressionNone && chunkSize > 0)
+        compressedSize =
+            recordCodec->compress(&columnScratch[0], &bufferRecord[position], chunkSize, chunkSize);
+      if (compressedSize <= 0 ||
+          compressedSize > (1.0 - minCompressionGain) * (double)chunkSize) {
+        if (chunkSize > 0)
+          memcpy(&bufferRecord[position], &columnScratch[0], chunkSize);
+        compressedSize  = chunkSize;
+        compressionType = kCompressionNone;
+      }
+      int entry = 56 + indexSize + 4 + c * 16;
+      hipo::utils::writeInt(&bufferRecord[0], entry, columnKeys[c]);
+      hipo::utils::writeInt(&bufferRecord[0], entry + 4, compressionType);
+      hipo::utils::writeInt(&bufferRecord[0], entry + 8, compressedSize);
+      hipo::utils::writeInt(&bufferRecord[0], entry + 12, chunkSize);
+      position += compressedSize;
+    }
+
+    int dataSize = position - 56 - indexSize - tableSize;
+    int rounding = getRecordLengthRounding(position);
+    memset(&bufferRecord[position], 0, rounding);
+    int recordWords = (position + rounding - 56) / 4;
+
+    int versionWord = (rounding << 24) | record::columnarBit | (4);
+    hipo::utils::writeInt(&bufferRecord[0], 0, recordWords + 14); // (1) record length in words
+    hipo::utils::writeInt(&bufferRecord[0], 4, 0);                // (2) record #
+    hipo::utils::writeInt(&bufferRecord[0], 8, 14);               // (3) header length in words
+    hipo::utils::writeInt(&bufferRecord[0], 12, nevents);         // (4) event count
+    hipo::utils::writeInt(&bufferRecord[0], 16, indexSize);       // (5) index array bytes
+    hipo::utils::writeInt(&bufferRecord[0], 20, versionWord);     // (6) record version number
+    hipo::utils::writeInt(&bufferRecord[0], 24, tableSize);       // (7) user header (chunk table)
+    hipo::utils::writeInt(&bufferRecord[0], 28, 0xc0da0100);      // (8) magic word
+    hipo::utils::writeInt(&bufferRecord[0], 32, dataSize);        // (9) chunks length in bytes
+    // the chunks are compressed one by one, the record itself is not
+    hipo::utils::writeInt(&bufferRecord[0], 36, 0x0FFFFFFF & recordWords);
+    hipo::utils::writeLong(&bufferRecord[0], 40, userWordOne);
+    hipo::utils::writeLong(&bufferRecord[0], 48, 0);
+  }
 
-#ifdef __LZ4__
-    //(const char* src, char* dst, int srcSize, int dstCapacity, int acceleration);
-    int result =
-        LZ4_compress_fast(&bufferData[0], &bufferRecord[56], src_size, bufferRecord.size(), 3);
-    // int   result = LZ4_decompress_safe(data,output,dataLength,dataLengthUncompressed);
-    // int   result = LZ4_decompress_fast(data,output,dataLengthUncompressed);
-    return result;
-#endif
-
-#ifndef __LZ4__
-    printf("\n   >>>>> LZ4 compression is not supported.");
-    printf("\n   >>>>> check if libz4 is installed on your system.");
-    printf("\n   >>>>> recompile the library with liblz4 installed.\n");
-    return 0;
-#endif
+  /**
+   * Adds an empty chunk for the structure key, with a zero length for
+   * each of the nevents events, and returns its number.
+   */
+  int recordbuilder::addColumnChunk(int key, int nevents) {
+    int chunk        = columnKeys.size();
+    columnIndex[key] = chunk;
+    columnKeys.push_back(key);
+    if ((int)columnData.size() <= chunk) {
+      columnData.resize(chunk + 1);
+      columnLengths.resize(chunk + 1);
+    }
+    columnData[chunk].clear();
+    columnLengths[chunk].assign(nevents, 0);
+    return chunk;
+  }
+
+  /**
+   * Compresses the data buffer into the record buffer after the header in
+   * blocks of blockSize bytes, preceded by the block table. Blocks that do
+   * not compress are stored as they are. Returns the size of the table and
+   * the blocks.
+   */
+  int recordbuilder::compressBlocks(int src_size) {
+    int nblocks   = (src_size + blockSize - 1) / blockSize;
+    int tableSize = 4 + nblocks * 12;
+    if (bufferRecord.size() < (size_t)(56 + tableSize + src_size + 4))
+      bufferRecord.resize(56 + tableSize + src_size + 4);
+    hipo::utils::writeInt(&bufferRecord[0], 56, nblocks);
+    int position = 56 + tableSize;
+    for (int b = 0; b < nblocks; b++) {
+      int         size   = std::min(blockSize, src_size - b * blockSize);
+      const char* block  = &bufferData[b * blockSize];
+      int         type   = recordCodec->getType();
+      int         result = recordCodec->compress(block, &bufferRecord[position], size, size);
+      if (result <= 0 || result >= size) {
+        memcpy(&bufferRecord[position], block, size);
+        result = size;
+        type   = kCompressionNone;
+      }
+      hipo::utils::writeInt(&bufferRecord[0], 60 + b * 12, type);
+      hipo::utils::writeInt(&bufferRecord[0], 64 + b * 12, result);
+      hipo::utils::writeInt(&bufferRecord[0], 68 + b * 12, size);
+      position += result;
+    }
+    return position - 56;
+  }
+
+  /**
+   * Compresses the data buffer into the record buffer after the header
+   * with the codec of the builder. Returns the compressed size, 0 if the
+   * compressed data did not fit.
+   */
+  int recordbuilder::compressRecord(int src_size) {
+    return recordCodec->compress(&bufferData[0], &bufferRecord[56], src_size,
+                                 bufferRecord.size() - 56 - 4);
   }
 } // namespace hipo
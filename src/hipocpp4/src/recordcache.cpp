@@ -0,0 +1,109 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/recordcache.h"
+
+namespace hipo {
+
+  /**
+   * Sets the maximum memory (bytes) used by the records in the cache,
+   * 0 disables the cache. Records that do not fit are evicted, least
+   * recently used first.
+   */
+  void recordCache::setMaxSize(long bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    maxSize = (bytes > 0) ? bytes : 0;
+    evict();
+  }
+
+  /**
+   * Removes all records from the cache, the hit and miss counters are
+   * kept. Must be called when the content of the records changes (other
+   * file, other banks selected).
+   */
+  void recordCache::clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entries.clear();
+    lookup.clear();
+    spare.reset();
+    cacheSize = 0;
+  }
+
+  void recordCache::resetCounters() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    hits   = 0;
+    misses = 0;
+  }
+
+  /**
+   * Returns the record at given file position and marks it as the most
+   * recently used one, or nullptr if the record is not in the cache. The
+   * returned record stays valid while it is held, even if it is evicted
+   * in the mean time.
+   */
+  std::shared_ptr<hipo::record> recordCache::find(long position) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto                        it = lookup.find(position);
+    if (it == lookup.end()) {
+      misses++;
+      return nullptr;
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->rec;
+  }
+
+  /**
+   * Returns a record to read a missed record into. The buffers of the
+   * last evicted record are reused if nobody holds it anymore.
+   */
+  std::shared_ptr<hipo::record> recordCache::create() {
+    std::lock_guard<std::mutex>   lock(cacheMutex);
+    std::shared_ptr<hipo::record> rec;
+    if (spare != nullptr && spare.use_count() == 1) {
+      rec.swap(spare);
+    } else {
+      rec = std::make_shared<hipo::record>();
+    }
+    return rec;
+  }
+
+  /**
+   * Adds a record read from given position as the most recently used one
+   * and evicts the least recently used records until the cache fits into
+   * the maximum size. The record just added is never evicted.
+   */
+  void recordCache::insert(long position, std::shared_ptr<hipo::record> rec) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (maxSize <= 0)
+      return;
+    auto it = lookup.find(position);
+    if (it != lookup.end()) {
+      // read by another cursor in the mean time
+      cacheSize -= it->second->size;
+      entries.erase(it->second);
+    }
+    cacheEntry_t entry;
+    entry.position = position;
+    entry.size     = rec->getMemorySize();
+    entry.rec      = rec;
+    entries.push_front(entry);
+    lookup[position] = entries.begin();
+    cacheSize += entry.size;
+    evict();
+  }
+
+  void recordCache::evict() {
+    while (entries.size() > 0 && (cacheSize > maxSize || maxSize <= 0)) {
+      if (maxSize > 0 && entries.size() == 1)
+        break;
+      cacheEntry_t& last = entries.back();
+      cacheSize -= last.size;
+      lookup.erase(last.position);
+      spare = last.rec;
+      entries.pop_back();
+    }
+  }
+} // namespace hipo
@@ -0,0 +1,168 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/runindex.h"
+#include "hipo4/reader.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace hipo {
+
+  static const int kIndexMagic   = 0x58444948; // "HIDX"
+  static const int kIndexVersion = 1;
+
+  static bool entryLess(const runIndexEntry_t& a, const runIndexEntry_t& b) {
+    if (a.run != b.run)
+      return a.run < b.run;
+    return a.event < b.event;
+  }
+
+  void runIndex::clear() {
+    indexEntries.clear();
+    indexFileSize = 0;
+  }
+
+  /**
+   * Builds the index for the records of the open reader, on nthreads
+   * threads (0 = number of cores) that each read whole records with their
+   * own stream. All banks are read, whatever the reader selected with
+   * setBanks(). Events without RUN::config are not in the index. Returns
+   * false if the file has no RUN::config bank or a record can not be
+   * read (the index is then incomplete).
+   */
+  bool runIndex::build(hipo::reader& r, int nthreads) {
+    clear();
+    hipo::dictionary dict;
+    r.readDictionary(dict);
+    if (dict.hasSchema("RUN::config") == false) {
+      std::cerr << "---> error : file " << r.getFileName() << " has no RUN::config bank"
+                << std::endl;
+      return false;
+    }
+    hipo::schema& config = dict.getSchema("RUN::config");
+
+    if (nthreads <= 0)
+      nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0)
+      nthreads = 1;
+
+    int                                       nrecords = r.getIndex().getMaxRecords();
+    std::atomic<int>                          nextRecord(0);
+    std::atomic<int>                          failed(0);
+    std::vector<std::vector<runIndexEntry_t>> results(nthreads);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < nthreads; t++) {
+      workers.push_back(std::thread([&r, &config, t, nrecords, &nextRecord, &failed, &results] {
+        std::ifstream stream;
+        if (r.isMemoryMapped() == false)
+          stream.open(r.getFileName().c_str(), std::ios::binary);
+        hipo::record rec;
+        hipo::event  event;
+        hipo::bank   runConfig(config);
+        int          recordNumber;
+        while ((recordNumber = nextRecord++) < nrecords) {
+          long position = r.getIndex().getPosition(recordNumber);
+          if (r.readRecord(rec, stream, position, false) == false) {
+            failed++;
+            continue;
+          }
+          int nevents = rec.getEventCount();
+          for (int i = 0; i < nevents; i++) {
+            rec.readHipoEvent(event, i);
+            event.getStructure(runConfig);
+            if (runConfig.getRows() < 1)
+              continue;
+            runIndexEntry_t entry;
+            entry.run      = runConfig.getInt("run", 0);
+            entry.event    = runConfig.getInt("event", 0);
+            entry.position = position;
+            entry.index    = i;
+            entry.reserved = 0;
+            results[t].push_back(entry);
+          }
+        }
+      }));
+    }
+    for (auto& worker : workers)
+      worker.join();
+    if (failed > 0) {
+      std::cerr << "---> error : " << failed << " records of " << r.getFileName()
+                << " can not be read, the index is incomplete" << std::endl;
+      clear();
+      return false;
+    }
+
+    for (auto& result : results)
+      indexEntries.insert(indexEntries.end(), result.begin(), result.end());
+    std::stable_sort(indexEntries.begin(), indexEntries.end(), entryLess);
+    indexFileSize = r.getFileSize();
+    return true;
+  }
+
+  bool runIndex::write(const std::string& filename) {
+    std::ofstream output(filename.c_str(), std::ios::binary);
+    if (output.is_open() == false) {
+      std::cerr << "---> error : can not open index file " << filename << std::endl;
+      return false;
+    }
+    long entries = indexEntries.size();
+    output.write(reinterpret_cast<const char*>(&kIndexMagic), 4);
+    output.write(reinterpret_cast<const char*>(&kIndexVersion), 4);
+    output.write(reinterpret_cast<const char*>(&indexFileSize), 8);
+    output.write(reinterpret_cast<const char*>(&entries), 8);
+    if (entries > 0)
+      output.write(reinterpret_cast<const char*>(&indexEntries[0]),
+                   entries * sizeof(runIndexEntry_t));
+    return output.good();
+  }
+
+  bool runIndex::read(const std::string& filename) {
+    clear();
+    std::ifstream input(filename.c_str(), std::ios::binary);
+    if (input.is_open() == false)
+      return false;
+    int  magic   = 0;
+    int  version = 0;
+    long entries = 0;
+    input.read(reinterpret_cast<char*>(&magic), 4);
+    input.read(reinterpret_cast<char*>(&version), 4);
+    input.read(reinterpret_cast<char*>(&indexFileSize), 8);
+    input.read(reinterpret_cast<char*>(&entries), 8);
+    if (input.good() == false || magic != kIndexMagic || version != kIndexVersion ||
+        entries < 0) {
+      std::cerr << "---> error : " << filename << " is not an event index file" << std::endl;
+      clear();
+      return false;
+    }
+    indexEntries.resize(entries);
+    if (entries > 0)
+      input.read(reinterpret_cast<char*>(&indexEntries[0]), entries * sizeof(runIndexEntry_t));
+    if (input.good() == false) {
+      std::cerr << "---> error : index file " << filename << " is truncated" << std::endl;
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Looks up the record position and the event number in the record for
+   * the run and event, returns false if the event is not in the index.
+   */
+  bool runIndex::find(int run, int event, long& position, int& index) {
+    runIndexEntry_t key;
+    key.run   = run;
+    key.event = event;
+    std::vector<runIndexEntry_t>::iterator it =
+        std::lower_bound(indexEntries.begin(), indexEntries.end(), key, entryLess);
+    if (it == indexEntries.end() || it->run != run || it->event != event)
+      return false;
+    position = it->position;
+    index    = it->index;
+    return true;
+  }
+} // namespace hipo
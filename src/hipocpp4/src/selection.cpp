@@ -0,0 +1,503 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/selection.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HIPO_SELECT_SIMD
+#include <immintrin.h>
+#endif
+
+namespace hipo {
+
+  selection& selection::range(const char* name, double low, double high) {
+    selectionCondition_t c;
+    c.name     = name;
+    c.low      = low;
+    c.high     = high;
+    c.absolute = false;
+    c.invert   = false;
+    conditions.push_back(c);
+    return *this;
+  }
+
+  selection& selection::absRange(const char* name, double low, double high) {
+    range(name, low, high);
+    conditions.back().absolute = true;
+    return *this;
+  }
+
+  /**
+   * All comparisons are expressed as ranges low <= value < high, the
+   * bound next to the value (nextafter) turns <= into < and > into >=.
+   */
+  selection& selection::equal(const char* name, double value) {
+    return range(name, value, std::nextafter(value, INFINITY));
+  }
+
+  selection& selection::notEqual(const char* name, double value) {
+    equal(name, value);
+    conditions.back().invert = true;
+    return *this;
+  }
+
+  selection& selection::less(const char* name, double value) {
+    return range(name, -INFINITY, value);
+  }
+
+  selection& selection::lessEqual(const char* name, double value) {
+    return range(name, -INFINITY, std::nextafter(value, INFINITY));
+  }
+
+  selection& selection::greater(const char* name, double value) {
+    return range(name, std::nextafter(value, INFINITY), INFINITY);
+  }
+
+  selection& selection::greaterEqual(const char* name, double value) {
+    return range(name, value, INFINITY);
+  }
+
+  /**
+   * Converts the range [low, high) of the condition to inclusive integer
+   * bounds [lo, hi] clamped to [min, max]. Returns false if no value in
+   * [min, max] can pass.
+   */
+  static bool integerBounds(const selectionCondition_t& c, int64_t min, int64_t max, int64_t& lo,
+                            int64_t& hi) {
+    double low  = std::ceil(c.low);
+    double high = std::ceil(c.high) - 1.0;
+    if (std::isnan(low) || std::isnan(high) || low > (double)max || high < (double)min)
+      return false;
+    // (double)max of int64 rounds up to 2^63, which does not convert back
+    lo = (low <= (double)min) ? min : (low >= (double)max) ? max : (int64_t)low;
+    hi = (high >= (double)max) ? max : (high <= (double)min) ? min : (int64_t)high;
+    if (low >= 9223372036854775808.0)
+      return false;
+    return lo <= hi;
+  }
+
+  static void applyEmpty(const selectionCondition_t& c, int rows, uint8_t* mask) {
+    if (c.invert == false)
+      std::memset(mask, 0, rows);
+  }
+
+  template <typename T>
+  static void selectIntegerScalar(const T* values, int start, int rows, int64_t lo, int64_t hi,
+                                  bool absolute, bool invert, uint8_t* mask) {
+    for (int i = start; i < rows; i++) {
+      int64_t v = values[i];
+      if (absolute && v < 0)
+        v = (v == std::numeric_limits<int64_t>::min()) ? -1 : -v;
+      bool inside = (v >= lo && v <= hi);
+      mask[i] &= (uint8_t)(inside != invert);
+    }
+  }
+
+  template <typename T>
+  static void selectFloatScalar(const T* values, int start, int rows, T low, T high, bool absolute,
+                                bool invert, uint8_t* mask) {
+    for (int i = start; i < rows; i++) {
+      T    v      = absolute ? std::fabs(values[i]) : values[i];
+      bool inside = (v >= low && v < high);
+      mask[i] &= (uint8_t)(inside != invert);
+    }
+  }
+
+#ifdef HIPO_SELECT_SIMD
+  // AVX2 kernels, compiled for AVX2 only (target attribute) and called
+  // only after the runtime check. Each returns the first row not handled,
+  // the rest is done by the scalar loop.
+
+  __attribute__((target("avx2"))) static int selectInt8AVX2(const int8_t* values, int rows,
+                                                            int64_t lo, int64_t hi, bool absolute,
+                                                            bool invert, uint8_t* mask) {
+    int i = 0;
+    if (absolute) {
+      // |-128| does not fit int8, the absolute values are compared as
+      // unsigned (same for int16 and int32)
+      __m256i vlo = _mm256_set1_epi8((char)(uint8_t)lo);
+      __m256i vhi = _mm256_set1_epi8((char)(uint8_t)hi);
+      for (; i + 32 <= rows; i += 32) {
+        __m256i  x    = _mm256_abs_epi8(_mm256_loadu_si256((const __m256i*)(values + i)));
+        __m256i  ge   = _mm256_cmpeq_epi8(_mm256_max_epu8(x, vlo), x);
+        __m256i  le   = _mm256_cmpeq_epi8(_mm256_min_epu8(x, vhi), x);
+        uint32_t bits = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(ge, le));
+        if (invert)
+          bits = ~bits;
+        for (int k = 0; k < 32; k++)
+          mask[i + k] &= (bits >> k) & 1;
+      }
+    } else {
+      __m256i vlo = _mm256_set1_epi8((char)lo);
+      __m256i vhi = _mm256_set1_epi8((char)hi);
+      for (; i + 32 <= rows; i += 32) {
+        __m256i  x       = _mm256_loadu_si256((const __m256i*)(values + i));
+        __m256i  outside = _mm256_or_si256(_mm256_cmpgt_epi8(vlo, x), _mm256_cmpgt_epi8(x, vhi));
+        uint32_t bits    = (uint32_t)_mm256_movemask_epi8(outside);
+        if (invert == false)
+          bits = ~bits;
+        for (int k = 0; k < 32; k++)
+          mask[i + k] &= (bits >> k) & 1;
+      }
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2"))) static int selectInt16AVX2(const int16_t* values, int rows,
+                                                             int64_t lo, int64_t hi, bool absolute,
+                                                             bool invert, uint8_t* mask) {
+    int i = 0;
+    // movemask_epi8 gives two bits per 16 bit lane, the even ones are used
+    if (absolute) {
+      __m256i vlo = _mm256_set1_epi16((short)(uint16_t)lo);
+      __m256i vhi = _mm256_set1_epi16((short)(uint16_t)hi);
+      for (; i + 16 <= rows; i += 16) {
+        __m256i  x    = _mm256_abs_epi16(_mm256_loadu_si256((const __m256i*)(values + i)));
+        __m256i  ge   = _mm256_cmpeq_epi16(_mm256_max_epu16(x, vlo), x);
+        __m256i  le   = _mm256_cmpeq_epi16(_mm256_min_epu16(x, vhi), x);
+        uint32_t bits = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(ge, le));
+        if (invert)
+          bits = ~bits;
+        for (int k = 0; k < 16; k++)
+          mask[i + k] &= (bits >> (2 * k)) & 1;
+      }
+    } else {
+      __m256i vlo = _mm256_set1_epi16((short)lo);
+      __m256i vhi = _mm256_set1_epi16((short)hi);
+      for (; i + 16 <= rows; i += 16) {
+        __m256i  x       = _mm256_loadu_si256((const __m256i*)(values + i));
+        __m256i  outside = _mm256_or_si256(_mm256_cmpgt_epi16(vlo, x),
+                                           _mm256_cmpgt_epi16(x, vhi));
+        uint32_t bits    = (uint32_t)_mm256_movemask_epi8(outside);
+        if (invert == false)
+          bits = ~bits;
+        for (int k = 0; k < 16; k++)
+          mask[i + k] &= (bits >> (2 * k)) & 1;
+      }
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2"))) static int selectInt32AVX2(const int32_t* values, int rows,
+                                                             int64_t lo, int64_t hi, bool absolute,
+                                                             bool invert, uint8_t* mask) {
+    int i = 0;
+    if (absolute) {
+      __m256i vlo = _mm256_set1_epi32((int)(uint32_t)lo);
+      __m256i vhi = _mm256_set1_epi32((int)(uint32_t)hi);
+      for (; i + 8 <= rows; i += 8) {
+        __m256i  x    = _mm256_abs_epi32(_mm256_loadu_si256((const __m256i*)(values + i)));
+        __m256i  ge   = _mm256_cmpeq_epi32(_mm256_max_epu32(x, vlo), x);
+        __m256i  le   = _mm256_cmpeq_epi32(_mm256_min_epu32(x, vhi), x);
+        uint32_t bits =
+            (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(ge, le)));
+        if (invert)
+          bits = ~bits;
+        for (int k = 0; k < 8; k++)
+          mask[i + k] &= (bits >> k) & 1;
+      }
+    } else {
+      __m256i vlo = _mm256_set1_epi32((int)lo);
+      __m256i vhi = _mm256_set1_epi32((int)hi);
+      for (; i + 8 <= rows; i += 8) {
+        __m256i  x       = _mm256_loadu_si256((const __m256i*)(values + i));
+        __m256i  outside = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, x),
+                                           _mm256_cmpgt_epi32(x, vhi));
+        uint32_t bits    = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(outside));
+        if (invert == false)
+          bits = ~bits;
+        for (int k = 0; k < 8; k++)
+          mask[i + k] &= (bits >> k) & 1;
+      }
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2"))) static int selectFloatAVX2(const float* values, int rows,
+                                                             float low, float high, bool absolute,
+                                                             bool invert, uint8_t* mask) {
+    int    i       = 0;
+    __m256 vlo     = _mm256_set1_ps(low);
+    __m256 vhi     = _mm256_set1_ps(high);
+    __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    for (; i + 8 <= rows; i += 8) {
+      __m256 x = _mm256_loadu_ps(values + i);
+      if (absolute)
+        x = _mm256_and_ps(x, absMask);
+      __m256 inside =
+          _mm256_and_ps(_mm256_cmp_ps(x, vlo, _CMP_GE_OQ), _mm256_cmp_ps(x, vhi, _CMP_LT_OQ));
+      uint32_t bits = (uint32_t)_mm256_movemask_ps(inside);
+      if (invert)
+        bits = ~bits;
+      for (int k = 0; k < 8; k++)
+        mask[i + k] &= (bits >> k) & 1;
+    }
+    return i;
+  }
+
+  // SSE4.1 kernels for CPUs without AVX2, same logic on 128 bit lanes
+
+  __attribute__((target("sse4.1"))) static int selectInt8SSE41(const int8_t* values, int rows,
+                                                               int64_t lo, int64_t hi,
+                                                               bool absolute, bool invert,
+                                                               uint8_t* mask) {
+    int i = 0;
+    if (absolute) {
+      __m128i vlo = _mm_set1_epi8((char)(uint8_t)lo);
+      __m128i vhi = _mm_set1_epi8((char)(uint8_t)hi);
+      for (; i + 16 <= rows; i += 16) {
+        __m128i  x    = _mm_abs_epi8(_mm_loadu_si128((const __m128i*)(values + i)));
+        __m128i  ge   = _mm_cmpeq_epi8(_mm_max_epu8(x, vlo), x);
+        __m128i  le   = _mm_cmpeq_epi8(_mm_min_epu8(x, vhi), x);
+        uint32_t bits = (uint32_t)_mm_movemask_epi8(_mm_and_si128(ge, le));
+        if (invert)
+          bits = ~bits;
+        for (int k = 0; k < 16; k++)
+          mask[i + k] &= (bits >> k) & 1;
+      }
+    } else {
+      __m128i vlo = _mm_set1_epi8((char)lo);
+      __m128i vhi = _mm_set1_epi8((char)hi);
+      for (; i + 16 <= rows; i += 16) {
+        __m128i  x       = _mm_loadu_si128((const __m128i*)(values + i));
+        __m128i  outside = _mm_or_si128(_mm_cmpgt_epi8(vlo, x), _mm_cmpgt_epi8(x, vhi));
+        uint32_t bits    = (uint32_t)_mm_movemask_epi8(outside);
+        if (invert == false)
+          bits = ~bits;
+        for (int k = 0; k < 16; k++)
+          mask[i + k] &= (bits >> k) & 1;
+      }
+    }
+    return i;
+  }
+
+  __attribute__((target("sse4.1"))) static int selectInt16SSE41(const int16_t* values, int rows,
+                                                                int64_t lo, int64_t hi,
+                                                                bool absolute, bool invert,
+                                                                uint8_t* mask) {
+    int i = 0;
+    if (absolute) {
+      __m128i vlo = _mm_set1_epi16((short)(uint16_t)lo);
+      __m128i vhi = _mm_set1_epi16((short)(uint16_t)hi);
+      for (; i + 8 <= rows; i += 8) {
+        __m128i  x    = _mm_abs_epi16(_mm_loadu_si128((const __m128i*)(values + i)));
+        __m128i  ge   = _mm_cmpeq_epi16(_mm_max_epu16(x, vlo), x);
+        __m128i  le   = _mm_cmpeq_epi16(_mm_min_epu16(x, vhi), x);
+        uint32_t bits = (uint32_t)_mm_movemask_epi8(_mm_and_si128(ge, le));
+        if (invert)
+          bits = ~bits;
+        for (int k = 0; k < 8; k++)
+          mask[i + k] &= (bits >> (2 * k)) & 1;
+      }
+    } else {
+      __m128i vlo = _mm_set1_epi16((short)lo);
+      __m128i vhi = _mm_set1_epi16((short)hi);
+      for (; i + 8 <= rows; i += 8) {
+        __m128i  x       = _mm_loadu_si128((const __m128i*)(values + i));
+        __m128i  outside = _mm_or_si128(_mm_cmpgt_epi16(vlo, x), _mm_cmpgt_epi16(x, vhi));
+        uint32_t bits    = (uint32_t)_mm_movemask_epi8(outside);
+        if (invert == false)
+          bits = ~bits;
+        for (int k = 0; k < 8; k++)
+          mask[i + k] &= (bits >> (2 * k)) & 1;
+      }
+    }
+    return i;
+  }
+
+  __attribute__((target("sse4.1"))) static int selectInt32SSE41(const int32_t* values, int rows,
+                                                                int64_t lo, int64_t hi,
+                                                                bool absolute, bool invert,
+                                                                uint8_t* mask) {
+    int i = 0;
+    if (absolute) {
+      __m128i vlo = _mm_set1_epi32((int)(uint32_t)lo);
+      __m128i vhi = _mm_set1_epi32((int)(uint32_t)hi);
+      for (; i + 4 <= rows; i += 4) {
+        __m128i  x    = _mm_abs_epi32(_mm_loadu_si128((const __m128i*)(values + i)));
+        __m128i  ge   = _mm_cmpeq_epi32(_mm_max_epu32(x, vlo), x);
+        __m128i  le   = _mm_cmpeq_epi32(_mm_min_epu32(x, vhi), x);
+        uint32_t bits = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(ge, le)));
+        if (invert)
+          bits = ~bits;
+        for (int k = 0; k < 4; k++)
+          mask[i + k] &= (bits >> k) & 1;
+      }
+    } else {
+      __m128i vlo = _mm_set1_epi32((int)lo);
+      __m128i vhi = _mm_set1_epi32((int)hi);
+      for (; i + 4 <= rows; i += 4) {
+        __m128i  x       = _mm_loadu_si128((const __m128i*)(values + i));
+        __m128i  outside = _mm_or_si128(_mm_cmpgt_epi32(vlo, x), _mm_cmpgt_epi32(x, vhi));
+        uint32_t bits    = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(outside));
+        if (invert == false)
+          bits = ~bits;
+        for (int k = 0; k < 4; k++)
+          mask[i + k] &= (bits >> k) & 1;
+      }
+    }
+    return i;
+  }
+
+  __attribute__((target("sse4.1"))) static int selectFloatSSE41(const float* values, int rows,
+                                                                float low, float high,
+                                                                bool absolute, bool invert,
+                                                                uint8_t* mask) {
+    int    i       = 0;
+    __m128 vlo     = _mm_set1_ps(low);
+    __m128 vhi     = _mm_set1_ps(high);
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (; i + 4 <= rows; i += 4) {
+      __m128 x = _mm_loadu_ps(values + i);
+      if (absolute)
+        x = _mm_and_ps(x, absMask);
+      // ordered compares, NaN is never inside (as in the scalar loop)
+      __m128   inside = _mm_and_ps(_mm_cmple_ps(vlo, x), _mm_cmplt_ps(x, vhi));
+      uint32_t bits   = (uint32_t)_mm_movemask_ps(inside);
+      if (invert)
+        bits = ~bits;
+      for (int k = 0; k < 4; k++)
+        mask[i + k] &= (bits >> k) & 1;
+    }
+    return i;
+  }
+#endif
+
+  /**
+   * Fastest kernel supported by the CPU, checked once.
+   */
+  static int supportedKernel() {
+#ifdef HIPO_SELECT_SIMD
+    static int kernel = __builtin_cpu_supports("avx2")     ? kSelectAVX2
+                        : __builtin_cpu_supports("sse4.1") ? kSelectSSE41
+                                                           : kSelectScalar;
+    return kernel;
+#else
+    return kSelectScalar;
+#endif
+  }
+
+  // kernel set with setSelectKernel(), -1 for the fastest one
+  static std::atomic<int> selectedKernel{-1};
+
+  int getSelectKernel() {
+    int kernel = selectedKernel.load();
+    return (kernel < 0) ? supportedKernel() : kernel;
+  }
+
+  /**
+   * Sets the kernels used by selectColumn(), limited to the ones the CPU
+   * supports, e.g. kSelectScalar to compare with the vector kernels.
+   * Returns the kernel used from now on.
+   */
+  int setSelectKernel(int kernel) {
+    kernel         = std::min(std::max(kernel, (int)kSelectScalar), supportedKernel());
+    selectedKernel = kernel;
+    return kernel;
+  }
+
+  /**
+   * True if the AVX2 kernels are used.
+   */
+  bool selectHasAVX2() { return getSelectKernel() == kSelectAVX2; }
+
+  void selectColumn(const int8_t* values, int rows, const selectionCondition_t& c, uint8_t* mask) {
+    int64_t lo, hi;
+    // the absolute value of an int8 goes up to 128
+    int64_t min = c.absolute ? 0 : -128;
+    int64_t max = c.absolute ? 128 : 127;
+    if (integerBounds(c, min, max, lo, hi) == false)
+      return applyEmpty(c, rows, mask);
+    int start = 0;
+#ifdef HIPO_SELECT_SIMD
+    int kernel = getSelectKernel();
+    if (kernel == kSelectAVX2)
+      start = selectInt8AVX2(values, rows, lo, hi, c.absolute, c.invert, mask);
+    else if (kernel == kSelectSSE41)
+      start = selectInt8SSE41(values, rows, lo, hi, c.absolute, c.invert, mask);
+#endif
+    selectIntegerScalar(values, start, rows, lo, hi, c.absolute, c.invert, mask);
+  }
+
+  void selectColumn(const int16_t* values, int rows, const selectionCondition_t& c,
+                    uint8_t* mask) {
+    int64_t lo, hi;
+    int64_t min = c.absolute ? 0 : -32768;
+    int64_t max = c.absolute ? 32768 : 32767;
+    if (integerBounds(c, min, max, lo, hi) == false)
+      return applyEmpty(c, rows, mask);
+    int start = 0;
+#ifdef HIPO_SELECT_SIMD
+    int kernel = getSelectKernel();
+    if (kernel == kSelectAVX2)
+      start = selectInt16AVX2(values, rows, lo, hi, c.absolute, c.invert, mask);
+    else if (kernel == kSelectSSE41)
+      start = selectInt16SSE41(values, rows, lo, hi, c.absolute, c.invert, mask);
+#endif
+    selectIntegerScalar(values, start, rows, lo, hi, c.absolute, c.invert, mask);
+  }
+
+  void selectColumn(const int32_t* values, int rows, const selectionCondition_t& c,
+                    uint8_t* mask) {
+    int64_t lo, hi;
+    int64_t min = c.absolute ? 0 : std::numeric_limits<int32_t>::min();
+    int64_t max = c.absolute ? (1LL << 31) : std::numeric_limits<int32_t>::max();
+    if (integerBounds(c, min, max, lo, hi) == false)
+      return applyEmpty(c, rows, mask);
+    int start = 0;
+#ifdef HIPO_SELECT_SIMD
+    int kernel = getSelectKernel();
+    if (kernel == kSelectAVX2)
+      start = selectInt32AVX2(values, rows, lo, hi, c.absolute, c.invert, mask);
+    else if (kernel == kSelectSSE41)
+      start = selectInt32SSE41(values, rows, lo, hi, c.absolute, c.invert, mask);
+#endif
+    selectIntegerScalar(values, start, rows, lo, hi, c.absolute, c.invert, mask);
+  }
+
+  void selectColumn(const float* values, int rows, const selectionCondition_t& c, uint8_t* mask) {
+    // rounding the bounds to float may move them, keep the range closed
+    // on the low side and open on the high side
+    float low  = (float)c.low;
+    float high = (float)c.high;
+    if ((double)low < c.low)
+      low = std::nextafter(low, INFINITY);
+    if ((double)high < c.high)
+      high = std::nextafter(high, INFINITY);
+    int start = 0;
+#ifdef HIPO_SELECT_SIMD
+    int kernel = getSelectKernel();
+    if (kernel == kSelectAVX2)
+      start = selectFloatAVX2(values, rows, low, high, c.absolute, c.invert, mask);
+    else if (kernel == kSelectSSE41)
+      start = selectFloatSSE41(values, rows, low, high, c.absolute, c.invert, mask);
+#endif
+    selectFloatScalar(values, start, rows, low, high, c.absolute, c.invert, mask);
+  }
+
+  /**
+   * double and int64 columns are evaluated with the scalar loop only.
+   */
+  void selectColumn(const double* values, int rows, const selectionCondition_t& c,
+                    uint8_t* mask) {
+    selectFloatScalar(values, 0, rows, c.low, c.high, c.absolute, c.invert, mask);
+  }
+
+  void selectColumn(const int64_t* values, int rows, const selectionCondition_t& c,
+                    uint8_t* mask) {
+    int64_t lo, hi;
+    // |INT64_MIN| does not fit, it never passes an absolute range
+    int64_t min = c.absolute ? 0 : std::numeric_limits<int64_t>::min();
+    int64_t max = std::numeric_limits<int64_t>::max();
+    if (integerBounds(c, min, max, lo, hi) == false)
+      return applyEmpty(c, rows, mask);
+    selectIntegerScalar(values, 0, rows, lo, hi, c.absolute, c.invert, mask);
+  }
+} // namespace hipo
@@ -0,0 +1,228 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/tailreader.h"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+namespace hipo {
+
+  /**
+   * Opens a file that may still be written. The file header and the
+   * dictionary record (user header) must already be in the file, which
+   * writers do at open time. Returns false if they are not (yet).
+   */
+  bool tailReader::open(const char* filename) {
+    close();
+    fileName       = filename;
+    fileDescriptor = ::open(filename, O_RDONLY);
+    if (fileDescriptor < 0) {
+      std::cerr << "[ERROR] something went wrong with openning file : " << filename << std::endl;
+      return false;
+    }
+    if (readFileHeader() == false) {
+      std::cerr << "[WARNING] file header of " << filename << " is not written yet" << std::endl;
+      close();
+      return false;
+    }
+#ifdef __linux__
+    notifyDescriptor = inotify_init1(IN_NONBLOCK);
+    if (notifyDescriptor >= 0 &&
+        inotify_add_watch(notifyDescriptor, filename, IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+      ::close(notifyDescriptor);
+      notifyDescriptor = -1;
+    }
+#endif
+    // the compression dictionary (structure 120/10) is needed for lz4dict records
+    hipo::record    dictRecord;
+    hipo::event     event;
+    hipo::structure dictStructure;
+    dictRecord.readRecord(fileDescriptor, headerLength, getFileSize());
+    for (int i = 0; i < dictRecord.getEventCount(); i++) {
+      dictRecord.readHipoEvent(event, i);
+      event.getStructure(dictStructure, 120, 10);
+      if (dictStructure.getSize() > 0) {
+        dictionaryCodec = codecRegistry::create(kCompressionLZ4Dict);
+        dictionaryCodec->setDictionary(dictStructure.getAddress() + 8, dictStructure.getSize());
+        break;
+      }
+    }
+    nextPosition = firstRecord;
+    return true;
+  }
+
+  void tailReader::close() {
+    if (fileDescriptor >= 0)
+      ::close(fileDescriptor);
+    if (notifyDescriptor >= 0)
+      ::close(notifyDescriptor);
+    fileDescriptor   = -1;
+    notifyDescriptor = -1;
+    fileFinished     = false;
+    recordEvents     = 0;
+    recordEvent      = 0;
+    failedRecords    = 0;
+    dictionaryCodec.reset();
+  }
+
+  long tailReader::getFileSize() {
+    struct stat st;
+    if (fstat(fileDescriptor, &st) != 0)
+      return 0;
+    return st.st_size;
+  }
+
+  /**
+   * Reads the file header words needed to walk the records (see
+   * reader.h), and the trailer position, which is set when the file
+   * is closed. Returns false if the header or the user header are
+   * not complete.
+   */
+  bool tailReader::readFileHeader() {
+    int words[14];
+    if (::pread(fileDescriptor, words, sizeof(words), 0) != sizeof(words))
+      return false;
+    int  length     = words[2];
+    int  userHeader = words[6];
+    long trailer;
+    std::memcpy(&trailer, &words[10], sizeof(trailer));
+    if (words[7] == 0x0001dac0) {
+      length     = __builtin_bswap32(length);
+      userHeader = __builtin_bswap32(userHeader);
+      trailer    = __builtin_bswap64(trailer);
+    }
+    headerLength    = 4L * length;
+    firstRecord     = headerLength + userHeader;
+    trailerPosition = trailer;
+    return getFileSize() >= firstRecord;
+  }
+
+  /**
+   * Reads the record at the next position if it is complete, returns
+   * false if it is not written yet. A complete record that can not be
+   * read is skipped with a warning (it has no events then) and counted
+   * by getFailedRecords(), so it is not read again. Sets the finished
+   * flag at the trailer index record.
+   */
+  bool tailReader::readNextRecord() {
+    long size = getFileSize();
+    if (nextPosition + 56 > size)
+      return false;
+    int words[14];
+    if (::pread(fileDescriptor, words, sizeof(words), nextPosition) != sizeof(words))
+      return false;
+    long recordLength = words[0];
+    if (words[7] == 0x0001dac0) {
+      recordLength = __builtin_bswap32(words[0]);
+    } else if (words[7] != (int)0xc0da0100) {
+      // header not written yet
+      return false;
+    }
+    recordLength *= 4;
+    if (recordLength < 56 || nextPosition + recordLength > size)
+      return false;
+
+    readFileHeader();
+    if (trailerPosition > 0 && nextPosition >= trailerPosition) {
+      fileFinished = true;
+      return false;
+    }
+    inputRecord.setDictionaryCodec(dictionaryCodec);
+    if (inputRecord.readRecord(fileDescriptor, nextPosition, size) == false) {
+      std::cerr << "[WARNING] record at position " << nextPosition
+                << " can not be read, its events are skipped" << std::endl;
+      nextPosition += recordLength;
+      recordEvents = 0;
+      recordEvent  = 0;
+      failedRecords++;
+      return true;
+    }
+    // the trailer can be written before the file header is updated
+    if (inputRecord.getEventCount() == 1) {
+      hipo::event     event;
+      hipo::structure base;
+      inputRecord.readHipoEvent(event, 0);
+      event.getStructure(base, 32111, 1);
+      if (base.getSize() > 0) {
+        fileFinished = true;
+        return false;
+      }
+    }
+    nextPosition += recordLength;
+    recordEvents = inputRecord.getEventCount();
+    recordEvent  = 0;
+    return true;
+  }
+
+  /**
+   * Waits for the file to change, at most the poll interval.
+   */
+  void tailReader::waitForData() {
+#ifdef __linux__
+    if (notifyDescriptor >= 0) {
+      struct pollfd pfd;
+      pfd.fd     = notifyDescriptor;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, pollInterval) > 0) {
+        char buffer[4096];
+        while (::read(notifyDescriptor, buffer, sizeof(buffer)) > 0) {
+        }
+      }
+      return;
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(pollInterval));
+  }
+
+  /**
+   * Reads the next event, waiting for new records to be written if
+   * all complete records are read. Returns false when the file is
+   * closed by the writer and all events are read, or when no new
+   * record was written within the timeout.
+   */
+  bool tailReader::next(hipo::event& dataevent) {
+    auto start = std::chrono::steady_clock::now();
+    while (recordEvent >= recordEvents) {
+      if (fileDescriptor < 0 || fileFinished == true)
+        return false;
+      // records without events (or skipped) are passed over
+      if (readNextRecord() == true)
+        continue;
+      if (fileFinished == true)
+        return false;
+      if (waitTimeout >= 0) {
+        auto waited = std::chrono::steady_clock::now() - start;
+        if (waited >= std::chrono::seconds(waitTimeout))
+          return false;
+      }
+      waitForData();
+    }
+    inputRecord.readHipoEvent(dataevent, recordEvent);
+    recordEvent++;
+    return true;
+  }
+
+  void tailReader::readDictionary(hipo::dictionary& dict) {
+    hipo::record    dictRecord;
+    hipo::structure schemaStructure;
+    hipo::event     event;
+    dictRecord.readRecord(fileDescriptor, headerLength, getFileSize());
+    for (int i = 0; i < dictRecord.getEventCount(); i++) {
+      dictRecord.readHipoEvent(event, i);
+      event.getStructure(schemaStructure, 120, 2);
+      if (schemaStructure.getSize() > 0)
+        dict.parse(schemaStructure.getStringAt(0).c_str());
+    }
+  }
+} // namespace hipo
@@ -0,0 +1,273 @@
+/*
+ * This sowftware was developed at Jefferson National Laboratory.
+ * (c) 2017.
+ */
+
+#include "hipo4/uring.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+#ifdef __URING__
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace hipo {
+
+  const int alignedBuffer::alignment;
+
+  /**
+   * Makes the buffer hold at least size bytes, rounded up to the
+   * alignment. Returns false if the memory can not be allocated.
+   */
+  bool alignedBuffer::reserve(long size) {
+    if (size <= bufferSize)
+      return true;
+    size      = (size + alignment - 1) / alignment * alignment;
+    void* mem = NULL;
+    if (posix_memalign(&mem, alignment, size) != 0) {
+      std::cerr << "---> error : can not allocate " << size << " bytes" << std::endl;
+      return false;
+    }
+    bufferData.reset(static_cast<char*>(mem));
+    bufferSize = size;
+    return true;
+  }
+
+#ifdef __URING__
+
+  static int uringSetup(unsigned entries, struct io_uring_params* params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+  }
+
+  static int uringEnter(int fd, unsigned submit, unsigned complete, unsigned flags) {
+    return syscall(__NR_io_uring_enter, fd, submit, complete, flags, NULL, 0);
+  }
+
+  /**
+   * Returns true if the kernel supports io_uring (it can be disabled or
+   * blocked by seccomp even on recent kernels).
+   */
+  bool uringReader::isAvailable() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = uringSetup(1, &params);
+    if (fd < 0)
+      return false;
+    ::close(fd);
+    return true;
+  }
+
+  /**
+   * Opens the file and sets up a ring with depth entries, which is the
+   * number of reads in flight. Returns false if io_uring can not be used,
+   * the caller should then read the file with its regular read path.
+   */
+  bool uringReader::open(const char* filename, int depth) {
+    close();
+    if (depth < 1)
+      depth = 1;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ringDescriptor = uringSetup(depth, &params);
+    if (ringDescriptor < 0)
+      return false;
+
+    queueDepth = params.sq_entries;
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    sqeSize    = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqRing     = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringDescriptor, IORING_OFF_SQ_RING);
+    cqRing     = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringDescriptor, IORING_OFF_CQ_RING);
+    sqEntries  = mmap(NULL, sqeSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringDescriptor, IORING_OFF_SQES);
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqEntries == MAP_FAILED) {
+      close();
+      return false;
+    }
+    char* sq  = reinterpret_cast<char*>(sqRing);
+    char* cq  = reinterpret_cast<char*>(cqRing);
+    sqTail    = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask    = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray   = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cqHead    = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail    = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask    = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqEntries = cq + params.cq_off.cqes;
+
+    fileDescriptor = ::open(filename, O_RDONLY);
+    if (fileDescriptor < 0) {
+      std::cerr << "[WARNING] can not open file for io_uring : " << filename << std::endl;
+      close();
+      return false;
+    }
+    fileSize = lseek(fileDescriptor, 0, SEEK_END);
+    return true;
+  }
+
+  void uringReader::close() {
+    if (sqRing != NULL && sqRing != MAP_FAILED)
+      munmap(sqRing, sqRingSize);
+    if (cqRing != NULL && cqRing != MAP_FAILED)
+      munmap(cqRing, cqRingSize);
+    if (sqEntries != NULL && sqEntries != MAP_FAILED)
+      munmap(sqEntries, sqeSize);
+    sqRing    = NULL;
+    cqRing    = NULL;
+    sqEntries = NULL;
+    if (ringDescriptor >= 0)
+      ::close(ringDescriptor);
+    if (fileDescriptor >= 0)
+      ::close(fileDescriptor);
+    ringDescriptor = -1;
+    fileDescriptor = -1;
+  }
+
+  /**
+   * Reads lengths[i] bytes at offsets[i] into destinations[i], queueDepth
+   * reads at a time. Short reads are completed with pread(). The kernel
+   * may accept fewer entries than asked, the rest is submitted again. If
+   * the ring fails, the reads already submitted are waited for (they
+   * write into the destinations) and the ring is closed, so the caller
+   * falls back to its regular read path.
+   */
+  bool uringReader::read(const std::vector<long>& offsets, const std::vector<long>& lengths,
+                         std::vector<char*>& destinations) {
+    struct io_uring_sqe* sqes = reinterpret_cast<struct io_uring_sqe*>(sqEntries);
+    struct io_uring_cqe* cqes = reinterpret_cast<struct io_uring_cqe*>(cqEntries);
+    std::vector<long>    done(offsets.size(), 0);
+
+    size_t first = 0;
+    while (first < offsets.size()) {
+      unsigned count = std::min<size_t>(queueDepth, offsets.size() - first);
+      unsigned tail  = *sqTail;
+      for (unsigned i = 0; i < count; i++) {
+        unsigned             slot = (tail + i) & *sqMask;
+        struct io_uring_sqe* sqe  = &sqes[slot];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode    = IORING_OP_READ;
+        sqe->fd        = fileDescriptor;
+        sqe->off       = offsets[first + i];
+        sqe->addr      = reinterpret_cast<unsigned long>(destinations[first + i]);
+        sqe->len       = lengths[first + i];
+        sqe->user_data = first + i;
+        sqArray[slot]  = slot;
+      }
+      __atomic_store_n(sqTail, tail + count, __ATOMIC_RELEASE);
+
+      unsigned submitted = 0;
+      unsigned completed = 0;
+      bool     failed    = false;
+      while (completed < submitted || (submitted < count && failed == false)) {
+        unsigned head = *cqHead;
+        if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+          struct io_uring_cqe* cqe = &cqes[head & *cqMask];
+          if (cqe->res > 0)
+            done[cqe->user_data] = cqe->res;
+          __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+          completed++;
+          continue;
+        }
+        unsigned toSubmit = (failed == false) ? count - submitted : 0;
+        unsigned toWait   = (completed < submitted) ? 1 : 0;
+        int      result   = uringEnter(ringDescriptor, toSubmit, toWait,
+                                       toWait > 0 ? IORING_ENTER_GETEVENTS : 0);
+        if (result > 0) {
+          submitted += std::min<unsigned>(result, toSubmit);
+        } else if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+          // keep collecting the completions of the submitted reads
+          failed = true;
+          if (completed < submitted)
+            sched_yield();
+        }
+      }
+      if (failed == true) {
+        std::cerr << "[WARNING] io_uring read failed, reading records with the stream"
+                  << std::endl;
+        close();
+        return false;
+      }
+      first += count;
+    }
+
+    for (size_t i = 0; i < offsets.size(); i++) {
+      while (done[i] < lengths[i]) {
+        ssize_t n = ::pread(fileDescriptor, destinations[i] + done[i], lengths[i] - done[i],
+                            offsets[i] + done[i]);
+        if (n <= 0)
+          return false;
+        done[i] += n;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Reads the records at given positions, with the lengths (header and
+   * data, in bytes) of the trailer index, into the buffers in one batch.
+   * The buffers are padded, so records can be decoded with
+   * record::readRecord(buffer->data(), 0, buffer->size()). Returns false
+   * if a record can not be read or its header does not have the length
+   * of the index, the caller should then read the records one by one.
+   */
+  bool uringReader::readRecords(const std::vector<long>&           positions,
+                                const std::vector<long>&           lengths,
+                                std::vector<hipo::alignedBuffer*>& buffers) {
+    int                nrecords = positions.size();
+    std::vector<char*> destinations(nrecords);
+    for (int i = 0; i < nrecords; i++) {
+      if (lengths[i] < 56 || positions[i] + lengths[i] > fileSize) {
+        std::cerr << "**** warning : record at position " << positions[i] << " is incomplete."
+                  << std::endl;
+        return false;
+      }
+      // padding for the size check of record::readRecord()
+      if (buffers[i]->reserve(lengths[i] + 80) == false)
+        return false;
+      destinations[i] = buffers[i]->data();
+    }
+    if (read(positions, lengths, destinations) == false)
+      return false;
+
+    for (int i = 0; i < nrecords; i++) {
+      const char* header = buffers[i]->data();
+      int         length = *(reinterpret_cast<const int*>(&header[0]));
+      int         magic  = *(reinterpret_cast<const int*>(&header[28]));
+      if (magic == 0x0001dac0)
+        length = __builtin_bswap32(length);
+      else if (magic != (int)0xc0da0100)
+        length = 0;
+      if (length * 4L != lengths[i]) {
+        std::cerr << "[WARNING] record at position " << positions[i]
+                  << " does not have the length of the file index" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+#else
+
+  bool uringReader::isAvailable() { return false; }
+  bool uringReader::open(const char* filename, int depth) { return false; }
+  void uringReader::close() {}
+  bool uringReader::read(const std::vector<long>& offsets, const std::vector<long>& lengths,
+                         std::vector<char*>& destinations) {
+    return false;
+  }
+  bool uringReader::readRecords(const std::vector<long>&           positions,
+                                const std::vector<long>&           lengths,
+                                std::vector<hipo::alignedBuffer*>& buffers) {
+    return false;
+  }
+
+#endif
+} // namespace hipo
@@ -54,17 +54,28 @@ int add_schema_(char* name, int length) {
   return __name;
 }
 
+// other column types are read row by row, as getInt() and getFloat() do
 void get_int_node_(int* scheme, int* bank, int* buffer) {
-  int length = hipo_bank_map.find(*scheme)->second->getRows();
+  hipo::bank* b = hipo_bank_map.find(*scheme)->second;
+  if (b->getSchema().getEntryType(*bank) == 3) {
+    b->copyColumn<int32_t>(*bank, buffer);
+    return;
+  }
+  int length = b->getRows();
   for (int i = 0; i < length; i++) {
-    buffer[i] = hipo_bank_map.find(*scheme)->second->getInt(*bank, i);
+    buffer[i] = b->getInt(*bank, i);
   }
 }
 
 void get_float_node_(int* scheme, int* bank, float* buffer) {
-  int length = hipo_bank_map.find(*scheme)->second->getRows();
+  hipo::bank* b = hipo_bank_map.find(*scheme)->second;
+  if (b->getSchema().getEntryType(*bank) == 4) {
+    b->copyColumn<float>(*bank, buffer);
+    return;
+  }
+  int length = b->getRows();
   for (int i = 0; i < length; i++) {
-    buffer[i] = hipo_bank_map.find(*scheme)->second->getFloat(*bank, i);
+    buffer[i] = b->getFloat(*bank, i);
   }
 }
 }
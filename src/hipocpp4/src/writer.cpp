@@ -4,11 +4,177 @@
  */
 
 #include "hipo4/writer.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 
 namespace hipo {
-  writer::writer(const char* filename) { writer::open(filename); }
-  writer::writer(const std::string& filename) { writer::open(filename.c_str()); }
+  writer::writer() {
+    writerBuilders.push_back(std::unique_ptr<hipo::recordbuilder>(new hipo::recordbuilder()));
+    tagBuilders[0] = writerBuilders[0].get();
+  }
+  writer::writer(const char* filename) : writer() { writer::open(filename); }
+  writer::writer(const std::string& filename) : writer() { writer::open(filename.c_str()); }
+
+  /**
+   * Sets the codec used for all records of the file (see codecRegistry),
+   * e.g. "lz4" with the acceleration as level, "lz4hc" with the HC level,
+   * or "none". Records where the codec saves less than the minimum gain
+   * (a fraction, 0 by default) are stored uncompressed. Set before open().
+   */
+  void writer::setCompression(int type, int level) {
+    std::shared_ptr<hipo::codec> c = codecRegistry::create(type, level);
+    if (c)
+      writerCodec = c;
+  }
+
+  void writer::setCompression(const std::string& name, int level) {
+    std::shared_ptr<hipo::codec> c = codecRegistry::create(name, level);
+    if (c)
+      writerCodec = c;
+  }
+
+  /**
+   * Enables column prefilters for all records (see prefilter.h):
+   * kPrefilterShuffle byte-shuffles float and double columns,
+   * kPrefilterDelta delta-encodes the integer columns with the given names
+   * (index, pindex and sector by default). Set before open().
+   */
+  void writer::setPrefilter(int flags) {
+    std::vector<std::string> deltaColumns = {"index", "pindex", "sector"};
+    setPrefilter(flags, deltaColumns);
+  }
+
+  void writer::setPrefilter(int flags, const std::vector<std::string>& deltaColumns) {
+    writerPrefilter    = flags;
+    writerDeltaColumns = deltaColumns;
+  }
+
+  /**
+   * Compresses all records with LZ4 and the given dictionary (see
+   * buildCompressionDictionary), the dictionary is stored in the file
+   * user header next to the schemas. Set before open().
+   */
+  void writer::setCompressionDictionary(const std::vector<char>& dict, int acceleration) {
+    writerCompressionDictionary = dict;
+    writerCodec                 = codecRegistry::create(kCompressionLZ4Dict, acceleration);
+    if (dict.size() > 0)
+      writerCodec->setDictionary(&dict[0], dict.size());
+  }
+
+  /**
+   * Builds a compression dictionary from sample events. This is not a
+   * trained dictionary (LZ4 has no trainer), it is the beginning of
+   * every sample event (bank headers and the first rows) put one after
+   * the other, each sample getting an equal share of maxSize bytes.
+   * Samples should be spread over the run, and be of the kind of events
+   * that will be written.
+   */
+  std::vector<char> writer::buildCompressionDictionary(std::vector<hipo::event>& samples,
+                                                       int maxSize) {
+    std::vector<char> dict;
+    if (samples.size() == 0)
+      return dict;
+    int share = maxSize / samples.size();
+    for (auto& sample : samples) {
+      int   length = std::min(sample.getSize(), share);
+      char* data   = &sample.getEventBuffer()[0];
+      dict.insert(dict.end(), data, data + length);
+    }
+    return dict;
+  }
+
+  /**
+   * Compresses records in independent blocks of the given size (bytes),
+   * so readers can decompress one record on several threads (see
+   * reader::setDecompressionThreads). Blocks of 256 KB to 1 MB keep the
+   * compression ratio close to the one of whole records, 0 (default)
+   * compresses each record in one piece. Set before open().
+   */
+  void writer::setBlockSize(int size) { writerBlockSize = (size > 0) ? size : 0; }
+
+  /**
+   * Keeps the minimum and maximum of the bank column in every record, in
+   * the trailer index of the file, so readers can skip records that can
+   * not pass a selection (see reader::addFilter). With an empty column
+   * name the number of rows of the bank is used, which also tells if
+   * the bank is in the record at all. Set before open().
+   */
+  void writer::addStatistics(const std::string& bank, const std::string& column) {
+    writerStatistics.push_back(std::make_pair(bank, column));
+  }
+
+  /**
+   * Checks the statistics against the dictionary, and creates the banks
+   * used to read the values from the events.
+   */
+  void writer::initStatistics() {
+    std::vector<std::pair<std::string, std::string>> statistics;
+    statisticsBanks.clear();
+    statisticsItems.clear();
+    for (auto& entry : writerStatistics) {
+      if (writerDictionary.hasSchema(entry.first.c_str()) == false) {
+        std::cerr << "---> error : statistics for unknown bank [" << entry.first << "]"
+                  << std::endl;
+        continue;
+      }
+      hipo::schema& schema = writerDictionary.getSchema(entry.first.c_str());
+      int           item   = -1;
+      if (entry.second.length() > 0) {
+        if (schema.hasEntry(entry.second.c_str()) == false) {
+          std::cerr << "---> error : statistics for unknown column [" << entry.first << "/"
+                    << entry.second << "]" << std::endl;
+          continue;
+        }
+        item = schema.getEntryOrder(entry.second.c_str());
+      }
+      statistics.push_back(entry);
+      statisticsBanks.push_back(std::unique_ptr<hipo::bank>(new hipo::bank(schema)));
+      statisticsItems.push_back(item);
+    }
+    writerStatistics = statistics;
+    eventStatistics.resize(2 * writerStatistics.size());
+  }
+
+  /**
+   * Computes the minimum and maximum of every statistic for the event,
+   * a column of a bank that is not in the event gives an empty range
+   * (minimum larger than the maximum).
+   */
+  void writer::fillStatistics(hipo::event& hevent) {
+    for (int s = 0; s < (int)statisticsBanks.size(); s++) {
+      hipo::bank& bank = *statisticsBanks[s];
+      int         item = statisticsItems[s];
+      hevent.getStructure(bank);
+      double low  = INFINITY;
+      double high = -INFINITY;
+      if (item < 0) {
+        low  = bank.getRows();
+        high = bank.getRows();
+      }
+      for (int row = 0; item >= 0 && row < bank.getRows(); row++) {
+        double value = 0.0;
+        switch (bank.getSchema().getEntryType(item)) {
+        case 4:
+          value = bank.getFloat(item, row);
+          break;
+        case 5:
+          value = bank.getDouble(item, row);
+          break;
+        case 8:
+          value = bank.getLong(item, row);
+          break;
+        default:
+          value = bank.getInt(item, row);
+          break;
+        }
+        low  = std::min(low, value);
+        high = std::max(high, value);
+      }
+      eventStatistics[2 * s]     = low;
+      eventStatistics[2 * s + 1] = high;
+    }
+  }
 
   void writer::open(const std::string& filename) { writer::open(filename.c_str()); }
   void writer::open(const char* filename) {
@@ -29,9 +195,25 @@ namespace hipo {
       structure schemaNodeJson(120, 1, schemaStringJson);
       schemaEvent.addStructure(schemaNode);
       schemaEvent.addStructure(schemaNodeJson);
+      // the compression dictionary goes with the first schema, so readers
+      // that do not know it still find a schema in every event
+      if (i == 0 && writerCompressionDictionary.size() > 0) {
+        std::string dictString(writerCompressionDictionary.begin(),
+                               writerCompressionDictionary.end());
+        structure   dictNode(120, 10, dictString);
+        schemaEvent.addStructure(dictNode);
+      }
       schemaEvent.show();
       builder.addEvent(schemaEvent);
     }
+    if (schemaList.size() == 0 && writerCompressionDictionary.size() > 0) {
+      std::string dictString(writerCompressionDictionary.begin(),
+                             writerCompressionDictionary.end());
+      structure   dictNode(120, 10, dictString);
+      schemaEvent.reset();
+      schemaEvent.addStructure(dictNode);
+      builder.addEvent(schemaEvent);
+    }
 
     builder.build();
 
@@ -57,24 +239,175 @@ namespace hipo {
 
     outputStream.write(reinterpret_cast<char*>(&builder.getRecordBuffer()[0]), dictionarySize);
     position = outputStream.tellp();
+
+    // one builder per compression thread besides the ones being filled
+    while (writerBuilders.size() < writerThreads + tagBuilders.size())
+      writerBuilders.push_back(std::unique_ptr<hipo::recordbuilder>(new hipo::recordbuilder()));
+    initStatistics();
+
+    writerFilter = hipo::prefilter();
+    if (writerPrefilter != 0)
+      writerFilter.setFilters(writerDictionary, writerPrefilter, writerDeltaColumns);
+    for (auto& builder : writerBuilders)
+      configureBuilder(*builder);
+
+    if (writerThreads > 0 && outputStream.is_open() == true) {
+      freeBuilders.clear();
+      for (auto& builder : writerBuilders) {
+        bool filling = false;
+        for (auto& entry : tagBuilders)
+          filling = filling || (entry.second == builder.get());
+        if (filling == false)
+          freeBuilders.push_back(builder.get());
+      }
+      nextSubmit = 0;
+      nextWrite  = 0;
+      writerStop = false;
+      for (int i = 0; i < writerThreads; i++)
+        writerWorkers.push_back(std::thread(&writer::workerLoop, this));
+    }
   }
 
-  void writer::addEvent(hipo::event& hevent) {
-    bool status = recordBuilder.addEvent(hevent);
+  void writer::configureBuilder(hipo::recordbuilder& builder) {
+    if (writerCodec)
+      builder.setCodec(writerCodec);
+    builder.setMinCompressionGain(writerMinGain);
+    builder.setPrefilter(writerFilter);
+    builder.setColumnar(writerColumnar);
+    builder.setBlockSize(writerBlockSize);
+  }
+
+  /**
+   * Returns the builder being filled for the tag, a new one is added to
+   * the builders for the first event of the tag.
+   */
+  hipo::recordbuilder*& writer::getBuilder(long tag) {
+    std::map<long, hipo::recordbuilder*>::iterator it = tagBuilders.find(tag);
+    if (it != tagBuilders.end())
+      return it->second;
+    hipo::recordbuilder* builder = new hipo::recordbuilder();
+    configureBuilder(*builder);
+    builder->setUserWordOne(tag);
+    std::lock_guard<std::mutex> lock(writerMutex);
+    writerBuilders.push_back(std::unique_ptr<hipo::recordbuilder>(builder));
+    tagBuilders[tag] = builder;
+    return tagBuilders[tag];
+  }
+
+  void writer::addEvent(hipo::event& hevent) { addEvent(hevent, 0); }
+
+  /**
+   * Adds the event to the records of the given tag. Every tag has its own
+   * records, with the tag as user word one, so readers can read only the
+   * records of some tags (see reader::setTags), e.g. scalers or helicity
+   * events without the physics events.
+   */
+  void writer::addEvent(hipo::event& hevent, long tag) {
+    hipo::recordbuilder*& builder = getBuilder(tag);
+    bool                  status  = builder->addEvent(hevent);
     if (status == false) {
-      writeRecord(recordBuilder);
-      recordBuilder.addEvent(hevent);
+      submitRecord(tag);
+      builder->addEvent(hevent);
+    }
+    if (writerStatistics.size() > 0) {
+      fillStatistics(hevent);
+      std::vector<double>& statistics = builder->getStatistics();
+      if (statistics.size() == 0) {
+        statistics = eventStatistics;
+      } else {
+        for (int s = 0; s < (int)statistics.size(); s += 2) {
+          statistics[s]     = std::min(statistics[s], eventStatistics[s]);
+          statistics[s + 1] = std::max(statistics[s + 1], eventStatistics[s + 1]);
+        }
+      }
+    }
+  }
+
+  /**
+   * Writes the current builder of the tag and leaves an empty one to add
+   * events to. With compression threads the builder is queued for the
+   * workers and a free one is taken, this only waits if all builders are
+   * in use.
+   */
+  void writer::submitRecord(long tag) {
+    hipo::recordbuilder*& builder = tagBuilders[tag];
+    if (writerWorkers.size() == 0) {
+      writeRecord(*builder);
+      return;
     }
+    std::unique_lock<std::mutex> lock(writerMutex);
+    writerCondition.wait(lock, [this] { return freeBuilders.size() > 0; });
+    buildQueue.push_back(std::make_pair(nextSubmit++, builder));
+    builder = freeBuilders.front();
+    freeBuilders.pop_front();
+    builder->setUserWordOne(tag);
+    writerCondition.notify_all();
+  }
+
+  /**
+   * Worker thread: compresses queued records, then writes all records
+   * that are ready in sequence order, unless another worker is already
+   * writing (it will pick them up before it stops).
+   */
+  void writer::workerLoop() {
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while (true) {
+      writerCondition.wait(lock, [this] { return buildQueue.size() > 0 || writerStop; });
+      if (buildQueue.size() == 0)
+        break;
+      std::pair<long, hipo::recordbuilder*> job = buildQueue.front();
+      buildQueue.pop_front();
+      lock.unlock();
+      job.second->build();
+      lock.lock();
+      builtRecords[job.first] = job.second;
+      if (writerBusy == true)
+        continue;
+      writerBusy = true;
+      std::map<long, hipo::recordbuilder*>::iterator it;
+      while ((it = builtRecords.find(nextWrite)) != builtRecords.end()) {
+        hipo::recordbuilder* builder = it->second;
+        builtRecords.erase(it);
+        lock.unlock();
+        writeBuiltRecord(*builder);
+        lock.lock();
+        freeBuilders.push_back(builder);
+        nextWrite++;
+        writerCondition.notify_all();
+      }
+      writerBusy = false;
+    }
+  }
+
+  /**
+   * Waits for the workers to write all queued records and stops them.
+   */
+  void writer::stopWorkers() {
+    if (writerWorkers.size() == 0)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(writerMutex);
+      writerStop = true;
+    }
+    writerCondition.notify_all();
+    for (auto& worker : writerWorkers)
+      worker.join();
+    writerWorkers.clear();
   }
 
   void writer::writeRecord(recordbuilder& builder) {
     builder.build();
+    writeBuiltRecord(builder);
+  }
+
+  void writer::writeBuiltRecord(recordbuilder& builder) {
     recordInfo_t recordInfo;
     recordInfo.recordPosition = outputStream.tellp();
     recordInfo.recordEntries  = builder.getEntries();
     recordInfo.recordLength   = builder.getRecordSize();
     recordInfo.userWordOne    = builder.getUserWordOne();
     recordInfo.userWordTwo    = builder.getUserWordTwo();
+    recordInfo.statistics     = builder.getStatistics();
     if (recordInfo.recordEntries > 0) {
       outputStream.write(reinterpret_cast<char*>(&builder.getRecordBuffer()[0]),
                          recordInfo.recordLength);
@@ -108,19 +441,52 @@ namespace hipo {
       indexBank.putLong("userWordTwo", i, recordInfo.userWordTwo);
     }
 
-    int eventSize = 32 * nEntries + 1024;
+    // statistics of the records : one row per record and statistic, the
+    // names of the statistics ("bank/column") are listed in 32111/3
+    int          nStatistics = writerStatistics.size();
+    hipo::schema statisticsSchema("file::statistics", 32111, 2);
+    statisticsSchema.parse("record/I,statistic/I,min/D,max/D");
+    hipo::bank  statisticsBank(statisticsSchema, nEntries * nStatistics);
+    std::string statisticsNames;
+    for (int i = 0; i < nEntries; i++) {
+      for (int s = 0; s < nStatistics; s++) {
+        std::vector<double>& statistics = writerRecordInfo[i].statistics;
+        int                  row        = i * nStatistics + s;
+        bool                 filled     = (int)statistics.size() == 2 * nStatistics;
+        statisticsBank.putInt("record", row, i);
+        statisticsBank.putInt("statistic", row, s);
+        statisticsBank.putDouble("min", row, filled ? statistics[2 * s] : -INFINITY);
+        statisticsBank.putDouble("max", row, filled ? statistics[2 * s + 1] : INFINITY);
+      }
+    }
+    for (auto& entry : writerStatistics)
+      statisticsNames += entry.first + "/" + entry.second + "\n";
+    hipo::structure statisticsList(32111, 3, statisticsNames);
+
+    int eventSize = 32 * nEntries + 24 * nEntries * nStatistics + statisticsNames.length() + 1024;
 
     hipo::event indexEvent(eventSize);
     indexEvent.addStructure(indexBank);
-    recordBuilder.reset();
-    recordBuilder.addEvent(indexEvent);
-    writeRecord(recordBuilder);
+    if (nStatistics > 0) {
+      indexEvent.addStructure(statisticsBank);
+      indexEvent.addStructure(statisticsList);
+    }
+    // the index is always read entirely, never in the columnar layout
+    hipo::recordbuilder* builder = tagBuilders[0];
+    builder->setColumnar(false);
+    builder->reset();
+    builder->addEvent(indexEvent);
+    writeRecord(*builder);
     outputStream.seekp(40);
     outputStream.write(reinterpret_cast<char*>(&indexPosition), 8);
   }
 
   void writer::close() {
-    writeRecord(recordBuilder);
+    if (outputStream.is_open() == false)
+      return;
+    for (auto& entry : tagBuilders)
+      submitRecord(entry.first);
+    stopWorkers();
     writeIndexTable();
     outputStream.close();
   }
@@ -0,0 +1,45 @@
+/*
+ * Builds the run/event lookup index (file.hipo.idx) of hipo4 files, used
+ * by hipo::reader::findEvent.
+ *
+ *    hipoindex [-t threads] file.hipo [file.hipo ...]
+ */
+#include "hipo4/runindex.h"
+#include "hipo4/reader.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char** argv) {
+  int                      nthreads = 0;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      nthreads = atoi(argv[++i]);
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.size() == 0) {
+    std::cerr << " usage : " << argv[0] << " [-t threads] file.hipo [file.hipo ...]" << std::endl;
+    exit(1);
+  }
+
+  int failed = 0;
+  for (auto& file : files) {
+    auto           start = std::chrono::high_resolution_clock::now();
+    hipo::reader   reader;
+    hipo::runIndex index;
+    reader.open(file.c_str());
+    std::string indexName = hipo::runIndex::getIndexName(file);
+    if (index.build(reader, nthreads) == false || index.write(indexName) == false) {
+      failed++;
+      continue;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    std::cout << indexName << " : " << index.getEntries() << " events, " << elapsed.count()
+              << " sec" << std::endl;
+  }
+  return failed > 0 ? 1 : 0;
+}
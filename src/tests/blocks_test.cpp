@@ -0,0 +1,45 @@
+/*
+ * Write/read round trip of block compressed records
+ * (writer::setBlockSize, bit 0x40000 of the record bit info),
+ * decompressed by one and by several threads. Records with a corrupt
+ * block table must be rejected.
+ */
+#include "roundtrip.h"
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "blocks_test.hipo";
+  long        nevents  = 50000;
+  roundtrip::writeFile(filename, nevents,
+                       [](hipo::writer& writer) { writer.setBlockSize(256 * 1024); });
+
+  long errors = 0;
+  for (int threads = 1; threads <= 4; threads += 3) {
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    reader.setDecompressionThreads(threads);
+    if ((roundtrip::recordWord(reader, 20) & hipo::record::blockBit) == 0) {
+      std::cerr << "records are not block compressed" << std::endl;
+      return 1;
+    }
+    errors += roundtrip::checkFile(reader, nevents);
+  }
+
+  // block table after the record header : count, then type, compressed
+  // and uncompressed size of every block
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  int blockSize    = roundtrip::recordWord(reader, 56 + 12);
+  int corrupt[][2] = {{56, 0x7FFFFFFF},      {56, 0x20000000},    {56, -1},
+                      {56 + 8, -1},          {56 + 8, 0x7FFFFFFF}, {56 + 12, -1},
+                      {56 + 12, 0x7FFFFFFF}, {56 + 12, blockSize - 1},
+                      {56 + 20, 0x7FFFFFFF}};
+  for (auto& word : corrupt) {
+    if (roundtrip::readCorrupted(filename, word[0], word[1]) == true) {
+      std::cerr << "record with word " << word[1] << " at offset " << word[0] << " was read"
+                << std::endl;
+      errors++;
+    }
+  }
+  printf("blocks_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+/*
+ * Reading several files as one sequence of events (hipo::chain). Events
+ * are numbered over all files, gotoEvent() moves across files, and a
+ * record that can not be read is skipped and counted without ending
+ * its file, also by forEachParallel().
+ */
+#include "roundtrip.h"
+#include "hipo4/chain.h"
+
+/**
+ * reads the chain with next(), every event must hold the content written
+ * for its number in its file, the first skipped events of the first file
+ * are missing. Returns the number of errors.
+ */
+static long checkChain(hipo::chain& chain, const std::vector<long>& nevents, long skipped) {
+  long        errors = 0;
+  long        first  = 0;
+  hipo::event event;
+  for (int f = 0; f < (int)nevents.size(); f++) {
+    for (long n = (f == 0) ? skipped : 0; n < nevents[f]; n++) {
+      if (chain.next(event) == false) {
+        std::cerr << "event " << n << " of file " << f << " was not read" << std::endl;
+        return errors + 1;
+      }
+      if (chain.getFileNumber() != f || chain.getEventNumber() != first + n) {
+        std::cerr << "event " << n << " of file " << f << " is event " << chain.getEventNumber()
+                  << " of file " << chain.getFileNumber() << std::endl;
+        errors++;
+      }
+      if (roundtrip::checkEvent(event, n) == false)
+        errors++;
+    }
+    first += nevents[f];
+  }
+  if (chain.next(event) == true) {
+    std::cerr << "read more events than expected" << std::endl;
+    errors++;
+  }
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  std::string              prefix  = (argc >= 2) ? argv[1] : "chain_test";
+  std::vector<long>        nevents = {250000, 1000, 0, 5000};
+  std::vector<std::string> files;
+  for (int f = 0; f < (int)nevents.size(); f++) {
+    files.push_back(prefix + "_" + std::to_string(f) + ".hipo");
+    roundtrip::writeFile(files[f], nevents[f], [](hipo::writer& writer) {});
+  }
+  long errors = 0;
+
+  hipo::chain chain(files);
+  if (chain.numFiles() != 4 || chain.numEvents() != 256000) {
+    std::cerr << "chain has " << chain.numFiles() << " files and " << chain.numEvents()
+              << " events" << std::endl;
+    return 1;
+  }
+  errors += checkChain(chain, nevents, 0);
+
+  // random access across files, then next() goes on from there
+  hipo::event event;
+  long        targets[] = {251500, 0, 250999, 250000, 255999, 100000};
+  for (long target : targets) {
+    long n = (target < 250000) ? target : (target < 251000) ? target - 250000 : target - 251000;
+    if (chain.readEvent(target, event) == false || roundtrip::checkEvent(event, n) == false) {
+      std::cerr << "can not read event " << target << " of the chain" << std::endl;
+      errors++;
+    }
+  }
+  if (chain.next(event) == false || chain.getEventNumber() != 100001 ||
+      roundtrip::checkEvent(event, 100001) == false) {
+    std::cerr << "next() does not continue after gotoEvent()" << std::endl;
+    errors++;
+  }
+  if (chain.gotoEvent(256000) == true || chain.gotoEvent(-1) == true) {
+    std::cerr << "gotoEvent() accepts events out of range" << std::endl;
+    errors++;
+  }
+
+  // unknown compression type in the first record of the first file
+  std::string  corrupt = prefix + "_corrupt.hipo";
+  hipo::reader reader;
+  reader.open(files[0].c_str());
+  long skipped = reader.getIndex().getFirstEvent(1);
+  roundtrip::copyFile(files[0], corrupt);
+  roundtrip::writeWord(corrupt, reader.getIndex().getPosition(0) + 36, 0x70000000);
+
+  std::vector<std::string> corrupted = files;
+  corrupted[0]                       = corrupt;
+  hipo::chain broken(corrupted);
+  errors += checkChain(broken, nevents, skipped);
+  long events = broken.forEachParallel(
+      4, 0L, [](hipo::event& e, long& count) { count++; },
+      [](long& total, long& count) { total += count; });
+  if (broken.getFailedRecords() != 2 || events != 256000 - skipped) {
+    std::cerr << "broken chain : " << broken.getFailedRecords() << " records failed, " << events
+              << " events processed" << std::endl;
+    errors++;
+  }
+  std::remove(corrupt.c_str());
+
+  printf("chain_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
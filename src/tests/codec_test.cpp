@@ -0,0 +1,107 @@
+/*
+ * Record codecs (codec.h, writer::setCompression). Each built-in codec
+ * and a codec added to the registry must write records with its type
+ * and read back the events, records that do not compress well enough
+ * (writer::setMinCompressionGain) are stored uncompressed.
+ */
+#include "roundtrip.h"
+#include "hipo4/codec.h"
+
+/**
+ * codec added to the registry by the test, xors every byte.
+ */
+class codecXor : public hipo::codec {
+public:
+  static const int type = 9;
+
+  int         getType() const { return type; }
+  std::string getName() const { return "xor"; }
+  int         compress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    if (srcSize > dstCapacity)
+      return 0;
+    for (int i = 0; i < srcSize; i++)
+      dst[i] = src[i] ^ 0x5a;
+    return srcSize;
+  }
+  int decompress(const char* src, char* dst, int srcSize, int dstCapacity) const {
+    return (srcSize > dstCapacity) ? -1 : compress(src, dst, srcSize, dstCapacity);
+  }
+};
+
+/**
+ * compresses and decompresses a buffer, half of it random bytes, with
+ * the codec of given type. Returns the number of errors.
+ */
+static long checkBuffer(int type) {
+  std::shared_ptr<hipo::codec> codec = hipo::codecRegistry::create(type);
+  if (!codec || codec->getType() != type) {
+    std::cerr << "registry has no codec of type " << type << std::endl;
+    return 1;
+  }
+  std::vector<char> data(100000);
+  for (int i = 0; i < (int)data.size(); i++)
+    data[i] = (i < 50000) ? (char)(i % 13) : (char)(rand() & 0xff);
+  std::vector<char> compressed(data.size() + data.size() / 255 + 16);
+  std::vector<char> decompressed(data.size());
+
+  int size = codec->compress(&data[0], &compressed[0], data.size(), compressed.size());
+  if (size > 0)
+    size = codec->decompress(&compressed[0], &decompressed[0], size, decompressed.size());
+  if (size != (int)data.size() || decompressed != data) {
+    std::cerr << codec->getName() << " : buffer does not survive the round trip" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "codec_test.hipo";
+  long        nevents  = 100000;
+  long        errors   = 0;
+
+  hipo::codecRegistry::add(codecXor::type, "xor", [](int level) { return new codecXor(); });
+  if (hipo::codecRegistry::getType("lz4hc") != hipo::kCompressionLZ4HC ||
+      hipo::codecRegistry::getType("xor") != codecXor::type ||
+      hipo::codecRegistry::create("unknown")) {
+    std::cerr << "wrong codecs in the registry" << std::endl;
+    errors++;
+  }
+
+  std::vector<std::string> names = {"none", "lz4", "lz4hc", "xor"};
+  std::vector<long>        sizes;
+  for (const std::string& name : names) {
+    errors += checkBuffer(hipo::codecRegistry::getType(name));
+    roundtrip::writeFile(filename, nevents,
+                         [&name](hipo::writer& writer) { writer.setCompression(name); });
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    int type = (roundtrip::recordWord(reader, 36) >> 28) & 0x0F;
+    if (type != hipo::codecRegistry::getType(name)) {
+      std::cerr << name << " : records have compression type " << type << std::endl;
+      errors++;
+    }
+    sizes.push_back(reader.getFileSize());
+    errors += roundtrip::checkFile(reader, nevents);
+  }
+  if (sizes[2] >= sizes[1] || sizes[1] >= sizes[0]) {
+    std::cerr << "file sizes none " << sizes[0] << ", lz4 " << sizes[1] << ", lz4hc " << sizes[2]
+              << std::endl;
+    errors++;
+  }
+
+  // LZ4 does not save 99 %, the records are stored
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {
+    writer.setCompression("lz4");
+    writer.setMinCompressionGain(0.99);
+  });
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  if (((roundtrip::recordWord(reader, 36) >> 28) & 0x0F) != hipo::kCompressionNone) {
+    std::cerr << "records below the minimum gain are compressed" << std::endl;
+    errors++;
+  }
+  errors += roundtrip::checkFile(reader, nevents);
+
+  printf("codec_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+/*
+ * Typed column handles (bank::getColumn). A handle reads the same values
+ * as the named getters and follows the content of the bank from event to
+ * event. A wrong column name or type gives an invalid handle with no rows.
+ */
+#include "roundtrip.h"
+
+int main() {
+  long errors = 0;
+
+  hipo::bank                  particles(roundtrip::particleSchema());
+  hipo::bank::column<int32_t> pid    = particles.getColumn<int32_t>("pid");
+  hipo::bank::column<float>   px     = particles.getColumn<float>("px");
+  hipo::bank::column<int8_t>  charge = particles.getColumn<int8_t>("charge");
+  hipo::bank::column<int16_t> status = particles.getColumn<int16_t>("status");
+  if (!pid.isValid() || !px.isValid() || !charge.isValid() || !status.isValid()) {
+    std::cerr << "column handles are not valid" << std::endl;
+    return 1;
+  }
+
+  hipo::event event;
+  for (long n = 0; n < 100; n++) {
+    roundtrip::fillEvent(event, n);
+    event.getStructure(particles);
+    if (pid.size() != roundtrip::particleRows(n)) {
+      std::cerr << "event " << n << " : handle has " << pid.size() << " rows" << std::endl;
+      errors++;
+    }
+    for (int r = 0; r < particles.getRows(); r++) {
+      if (pid[r] != particles.getInt("pid", r) || px[r] != particles.getFloat("px", r) ||
+          charge[r] != particles.getByte("charge", r) ||
+          status[r] != particles.getShort("status", r)) {
+        std::cerr << "event " << n << " : wrong value in row " << r << std::endl;
+        errors++;
+      }
+    }
+  }
+
+  // wrong name and wrong type
+  hipo::bank::column<float>   missing = particles.getColumn<float>("energy");
+  hipo::bank::column<int32_t> wrong   = particles.getColumn<int32_t>("px");
+  hipo::bank::column<float>   unset;
+  if (missing.isValid() || wrong.isValid() || unset.isValid() || missing.size() != 0 ||
+      wrong.size() != 0 || unset.size() != 0) {
+    std::cerr << "invalid column handles are not reported" << std::endl;
+    errors++;
+  }
+
+  printf("column_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
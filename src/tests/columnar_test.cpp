@@ -0,0 +1,44 @@
+/*
+ * Write/read round trip of columnar records (writer::setColumnar, bit
+ * 0x20000 of the record bit info), reading all banks and only some.
+ * Records with a corrupt chunk table must be rejected.
+ */
+#include "roundtrip.h"
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "columnar_test.hipo";
+  long        nevents  = 50000;
+  roundtrip::writeFile(filename, nevents,
+                       [](hipo::writer& writer) { writer.setColumnar(true); });
+
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  if ((roundtrip::recordWord(reader, 20) & hipo::record::columnarBit) == 0) {
+    std::cerr << "records are not columnar" << std::endl;
+    return 1;
+  }
+  long errors = roundtrip::checkFile(reader, nevents);
+
+  hipo::reader selected;
+  selected.open(filename.c_str());
+  selected.setBanks({"REC::Event"});
+  errors += roundtrip::checkFile(selected, nevents, false);
+
+  // chunk table : count, then key, type, compressed and uncompressed size
+  int table        = 56 + roundtrip::recordWord(reader, 16);
+  int recordEvents = roundtrip::recordWord(reader, 12);
+  int corrupt[][2] = {{table, 0x7FFFFFFF},
+                      {table, -1},
+                      {table + 4 + 16 + 8, 0x7FFFFFFF},
+                      {table + 4 + 16 + 12, -1},
+                      {table + 4 + 16 + 12, 4 * recordEvents}};
+  for (auto& word : corrupt) {
+    if (roundtrip::readCorrupted(filename, word[0], word[1]) == true) {
+      std::cerr << "record with word " << word[1] << " at offset " << word[0] << " was read"
+                << std::endl;
+      errors++;
+    }
+  }
+  printf("columnar_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/*
+ * Table of bank positions of an event (hipo::eventIndex). Lookups through
+ * the table must give the position found by walking the structure
+ * headers, also after the event is changed (addStructure, init, reset,
+ * getEventBuffer) and for keys at the limits of group and item.
+ */
+#include "roundtrip.h"
+
+/**
+ * position and length of the first structure (group,item) found by
+ * walking the structure headers, (-1,0) if there is none.
+ */
+static std::pair<int, int> walk(hipo::event& event, int group, int item) {
+  const char* buffer   = &event.getEventBuffer()[0];
+  int         position = 16;
+  while (position + 8 < event.getSize()) {
+    int gid    = *(reinterpret_cast<const uint16_t*>(&buffer[position]));
+    int iid    = *(reinterpret_cast<const uint8_t*>(&buffer[position + 2]));
+    int length = *(reinterpret_cast<const int*>(&buffer[position + 4]));
+    if (gid == group && iid == item)
+      return std::make_pair(position, length);
+    position += length + 8;
+  }
+  return std::make_pair(-1, 0);
+}
+
+static hipo::bank makeBank(int group, int item, int rows, int value) {
+  hipo::schema schema("TEST::bank", group, item);
+  schema.parse("value/I");
+  hipo::bank bank(schema, rows);
+  for (int r = 0; r < rows; r++)
+    bank.putInt("value", r, value);
+  return bank;
+}
+
+/**
+ * looks up every key with the table and compares with the walk. All
+ * lookups are done first, getEventBuffer() in walk() drops the table.
+ */
+static long checkLookups(hipo::event& event, const std::vector<std::pair<int, int>>& keys,
+                         const char* step) {
+  std::vector<std::pair<int, int>> found;
+  for (const std::pair<int, int>& key : keys)
+    found.push_back(event.getStructurePosition(key.first, key.second));
+
+  long errors = 0;
+  for (int k = 0; k < (int)keys.size(); k++) {
+    std::pair<int, int> expected = walk(event, keys[k].first, keys[k].second);
+    if (found[k] != expected) {
+      std::cerr << step << " : bank " << keys[k].first << "/" << keys[k].second << " found at "
+                << found[k].first << ", expected " << expected.first << std::endl;
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int main() {
+  long                             errors = 0;
+  std::vector<std::pair<int, int>> keys   = {{300, 1},   {300, 31}, {1, 0},   {65535, 255},
+                                             {300, 255}, {255, 44}, {42, 42}, {10000, 11}};
+  hipo::event event;
+  event.reset();
+  for (int k = 0; k < 5; k++) {
+    hipo::bank bank = makeBank(keys[k].first, keys[k].second, 1 + k, k);
+    event.addStructure(bank);
+  }
+  errors += checkLookups(event, keys, "first banks");
+
+  // added after the table was built
+  hipo::bank added = makeBank(42, 42, 3, 7);
+  event.addStructure(added);
+  errors += checkLookups(event, keys, "added bank");
+
+  // the first of two banks with the same key is returned
+  hipo::bank duplicate = makeBank(300, 1, 9, 8);
+  event.addStructure(duplicate);
+  std::pair<int, int> first = event.getStructurePosition(300, 1);
+  if (first.second != 4) {
+    std::cerr << "bank 300/1 has length " << first.second << ", expected the first bank"
+              << std::endl;
+    errors++;
+  }
+  errors += checkLookups(event, keys, "duplicate bank");
+
+  // content replaced through the buffer : the bank 300/1 becomes 300/2
+  event.getEventBuffer()[first.first + 2] = 2;
+  keys.push_back(std::make_pair(300, 2));
+  errors += checkLookups(event, keys, "modified buffer");
+
+  // other event copied in, then emptied
+  hipo::event other;
+  roundtrip::fillEvent(other, 12);
+  event.init(&other.getEventBuffer()[0], other.getSize());
+  errors += checkLookups(event, keys, "init");
+  if (roundtrip::checkEvent(event, 12) == false)
+    errors++;
+  event.reset();
+  errors += checkLookups(event, keys, "reset");
+
+  printf("eventindex_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+/*
+ * Zero-copy event views (reader::read(eventView&), eventView::getStructure).
+ * A bank view points into the decompressed record, a bank filled from the
+ * view holds a copy, both must hold the banks written, also with the
+ * read-ahead and for banks missing in the event.
+ */
+#include "roundtrip.h"
+
+/**
+ * reads all events of the file as views and checks the bank views and
+ * the banks copied from the views. Returns the number of errors.
+ */
+static long checkViews(hipo::reader& reader, long nevents) {
+  hipo::schema config("RUN::config", 10000, 11);
+  config.parse("run/I,event/I");
+
+  hipo::eventView view;
+  hipo::bankView  header(roundtrip::eventSchema());
+  hipo::bankView  particles(roundtrip::particleSchema());
+  hipo::bank      copy(roundtrip::particleSchema());
+  hipo::bankView  missing(config);
+  long            errors = 0;
+  long            n      = 0;
+  for (; reader.next() == true; n++) {
+    reader.read(view);
+    view.getStructure(header);
+    view.getStructure(particles);
+    view.getStructure(missing);
+    if (roundtrip::checkBanks(header, particles, n) == false || missing.getRows() != 0) {
+      errors++;
+      continue;
+    }
+    // the view points into the event, the bank copy does not
+    const char* begin = view.getEventData();
+    const char* end   = begin + view.getSize();
+    if (particles.getAddress() < begin || particles.getAddress() >= end) {
+      std::cerr << "event " << n << " : bank view does not point into the event" << std::endl;
+      errors++;
+    }
+    view.getStructure(copy);
+    if (roundtrip::checkBanks(header, copy, n) == false ||
+        (copy.getAddress() >= begin && copy.getAddress() < end)) {
+      std::cerr << "event " << n << " : wrong bank copied from the view" << std::endl;
+      errors++;
+    }
+  }
+  if (n != nevents) {
+    std::cerr << "read " << n << " events, expected " << nevents << std::endl;
+    errors++;
+  }
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "eventview_test.hipo";
+  long        nevents  = 100000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+  long errors = 0;
+
+  for (int prefetch = 0; prefetch < 2; prefetch++) {
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    reader.setPrefetch(prefetch * 2);
+    errors += checkViews(reader, nevents);
+  }
+
+  printf("eventview_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+/*
+ * Shared file handles and per-thread cursors (hipo::fileHandle,
+ * hipo::fileCursor). Cursors read records with pread() and do not share
+ * a file position : cursors used in turn and cursors on several threads
+ * must all read every event, records read by several cursors come from
+ * the shared cache.
+ */
+#include "roundtrip.h"
+#include "hipo4/filehandle.h"
+#include <atomic>
+#include <thread>
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "filehandle_test.hipo";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+  long errors = 0;
+
+  if (hipo::fileHandle::open(filename + ".missing") != nullptr) {
+    std::cerr << "handle opened for a missing file" << std::endl;
+    errors++;
+  }
+  std::shared_ptr<hipo::fileHandle> handle = hipo::fileHandle::open(filename);
+  if (handle == nullptr || handle->numEvents() != nevents ||
+      handle->getIndex().getMaxRecords() < 3) {
+    std::cerr << "expected a handle of " << nevents << " events in 3 records or more" << std::endl;
+    return 1;
+  }
+  hipo::dictionary dict;
+  handle->readDictionary(dict);
+  if (dict.hasSchema("REC::Particle") == false) {
+    std::cerr << "handle has no REC::Particle schema" << std::endl;
+    errors++;
+  }
+
+  // every thread reads all events with its own cursor
+  std::atomic<long>        threadErrors{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.push_back(std::thread([&handle, &threadErrors, nevents]() {
+      hipo::fileCursor cursor(handle);
+      hipo::event      event;
+      long             n = 0;
+      for (; cursor.next(event) == true; n++) {
+        if (cursor.getEventNumber() != n || roundtrip::checkEvent(event, n) == false)
+          threadErrors++;
+      }
+      if (n != nevents)
+        threadErrors++;
+    }));
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  errors += threadErrors;
+
+  // cursors used in turn keep their own position, the second one jumps around
+  handle->setCacheSize(1L << 30);
+  hipo::fileCursor first(handle);
+  hipo::fileCursor second(handle);
+  hipo::event      event;
+  long             step = handle->getIndex().getFirstEvent(1) + 17;
+  for (long n = 0; n < nevents; n++) {
+    long other = (n * step) % nevents;
+    if (first.next(event) == false || roundtrip::checkEvent(event, n) == false ||
+        second.readEvent(other, event) == false || roundtrip::checkEvent(event, other) == false) {
+      std::cerr << "cursors read wrong events at event " << n << std::endl;
+      errors++;
+      break;
+    }
+  }
+  if (handle->getCacheHits() == 0 ||
+      handle->getCacheMisses() != handle->getIndex().getMaxRecords()) {
+    std::cerr << "shared cache has " << handle->getCacheHits() << " hits and "
+              << handle->getCacheMisses() << " misses" << std::endl;
+    errors++;
+  }
+  if (first.next(event) == true || second.gotoEvent(nevents) == true) {
+    std::cerr << "cursors read past the last event" << std::endl;
+    errors++;
+  }
+
+  printf("filehandle_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+/*
+ * Run/event lookup index (hipo::runIndex, reader::findEvent). The index
+ * is built from RUN::config of every event, also when the reader selects
+ * other banks of columnar records, and is not built if a record can not
+ * be read.
+ */
+#include "roundtrip.h"
+#include "hipo4/runindex.h"
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "findevent_test.hipo";
+  long        nevents  = 100000;
+
+  hipo::schema config("RUN::config", 10000, 11);
+  config.parse("run/I,event/I");
+  {
+    hipo::writer writer;
+    writer.getDictionary().addSchema(roundtrip::eventSchema());
+    writer.getDictionary().addSchema(roundtrip::particleSchema());
+    writer.getDictionary().addSchema(config);
+    writer.setColumnar(true);
+    writer.open(filename);
+    hipo::event event;
+    hipo::bank  runConfig(config, 1);
+    for (long n = 0; n < nevents; n++) {
+      roundtrip::fillEvent(event, n);
+      runConfig.putInt("run", 0, 5000 + n % 3);
+      runConfig.putInt("event", 0, n);
+      event.addStructure(runConfig);
+      writer.addEvent(event);
+    }
+    writer.close();
+  }
+  long errors = 0;
+
+  hipo::runIndex index;
+  {
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    reader.setBanks({"REC::Event"});
+    if (index.build(reader, 4) == false || index.getEntries() != nevents ||
+        index.write(hipo::runIndex::getIndexName(filename)) == false) {
+      std::cerr << "index has " << index.getEntries() << " events" << std::endl;
+      return 1;
+    }
+  }
+
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  hipo::event event;
+  long        targets[] = {77777, 0, nevents - 1, 12345, 12346, 50000};
+  for (long n : targets) {
+    int run = 5000 + n % 3;
+    if (reader.findEvent(run, n, event) == false || roundtrip::checkEvent(event, n) == false) {
+      std::cerr << "can not find run " << run << " event " << n << std::endl;
+      errors++;
+    }
+  }
+  if (reader.findEvent(5001, 3, event) == true || reader.findEvent(5000, nevents, event) == true) {
+    std::cerr << "found an event that is not in the file" << std::endl;
+    errors++;
+  }
+  if (reader.next(event) == false || roundtrip::checkEvent(event, 0) == false) {
+    std::cerr << "findEvent() moved the reader" << std::endl;
+    errors++;
+  }
+
+  // unknown compression type in the first record
+  std::string corrupt = filename + ".corrupt";
+  roundtrip::copyFile(filename, corrupt);
+  roundtrip::writeWord(corrupt, reader.getIndex().getPosition(0) + 36, 0x70000000);
+  hipo::reader broken;
+  broken.open(corrupt.c_str());
+  if (index.build(broken) == true || index.getEntries() != 0) {
+    std::cerr << "index built for a file with a corrupt record" << std::endl;
+    errors++;
+  }
+  std::remove(corrupt.c_str());
+
+  printf("findevent_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
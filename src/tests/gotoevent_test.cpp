@@ -0,0 +1,71 @@
+/*
+ * Random access to events (reader::gotoEvent, reader::readEvent). The
+ * record holding an event is found in the cumulative event counts of
+ * the index, which are counted with long : event numbers past 2^31 must
+ * neither wrap nor be accepted when they are out of range.
+ */
+#include "roundtrip.h"
+
+/**
+ * index of three records of 2e9 events each, only the counts are used.
+ */
+static long checkLargeIndex() {
+  long              errors = 0;
+  hipo::readerIndex index;
+  for (int r = 0; r < 3; r++) {
+    index.addPosition(r * 1000L);
+    index.addSize(2000000000);
+  }
+  index.rewind();
+  if (index.getMaxEvents() != 6000000000L || index.findRecord(2000000000L) != 1) {
+    std::cerr << "index has " << index.getMaxEvents() << " events" << std::endl;
+    errors++;
+  }
+  if (index.gotoEvent(5000000000L) == false || index.getEventNumber() != 5000000000L ||
+      index.getRecordNumber() != 2 || index.getRecordEventNumber() != 1000000000) {
+    std::cerr << "event 5e9 is event " << index.getRecordEventNumber() << " of record "
+              << index.getRecordNumber() << std::endl;
+    errors++;
+  }
+  if (index.gotoEvent(6000000000L) == true || index.gotoEvent(-1) == true) {
+    std::cerr << "index accepts events out of range" << std::endl;
+    errors++;
+  }
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "gotoevent_test.hipo";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+  long errors = checkLargeIndex();
+
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  hipo::event event;
+  long        targets[] = {nevents - 1, 0, 123456, 123457, 123455, nevents / 2, 1};
+  for (long target : targets) {
+    if (reader.readEvent(target, event) == false || reader.getEventNumber() != target ||
+        roundtrip::checkEvent(event, target) == false) {
+      std::cerr << "can not read event " << target << std::endl;
+      errors++;
+    }
+  }
+  // next() goes on from the event reached
+  if (reader.next(event) == false || roundtrip::checkEvent(event, 2) == false) {
+    std::cerr << "next() does not continue after readEvent()" << std::endl;
+    errors++;
+  }
+
+  // numbers that wrapped to valid events when converted to int
+  long outside[] = {-1, nevents, (1L << 32), (1L << 32) + 5, -(1L << 32) + 5};
+  for (long target : outside) {
+    if (reader.gotoEvent(target) == true) {
+      std::cerr << "gotoEvent() accepts event " << target << std::endl;
+      errors++;
+    }
+  }
+
+  printf("gotoevent_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+/*
+ * Records compressed with an LZ4 dictionary (writer::setCompressionDictionary,
+ * compression type 4). The dictionary is stored in the file and must reach
+ * every read path : stream, memory mapped file and read-ahead.
+ */
+#include "roundtrip.h"
+#include "hipo4/codec.h"
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "lz4dict_test.hipo";
+  long        nevents  = 50000;
+  long        errors   = 0;
+
+  std::vector<hipo::event> samples(64);
+  for (int n = 0; n < (int)samples.size(); n++)
+    roundtrip::fillEvent(samples[n], n);
+  std::vector<char> dictionary = hipo::writer::buildCompressionDictionary(samples, 4096);
+  if (dictionary.size() == 0 || dictionary.size() > 4096) {
+    std::cerr << "dictionary has " << dictionary.size() << " bytes" << std::endl;
+    errors++;
+  }
+  roundtrip::writeFile(filename, nevents, [&dictionary](hipo::writer& writer) {
+    writer.setCompressionDictionary(dictionary);
+  });
+
+  for (int mode = 0; mode < 3; mode++) {
+    hipo::reader reader;
+    reader.setMemoryMapped(mode == 1);
+    reader.open(filename.c_str());
+    if (mode == 2)
+      reader.setPrefetch(2);
+    int compressionType = (roundtrip::recordWord(reader, 36) >> 28) & 0x0F;
+    if (compressionType != hipo::kCompressionLZ4Dict) {
+      std::cerr << "records have compression type " << compressionType << std::endl;
+      return 1;
+    }
+    errors += roundtrip::checkFile(reader, nevents);
+  }
+  printf("lz4dict_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
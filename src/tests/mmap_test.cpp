@@ -0,0 +1,83 @@
+/*
+ * Reading with and without memory mapping (reader::setMemoryMapped).
+ * A record that can not be read is skipped and counted, the reader goes
+ * on with the next record. Records cut short by the writers before the
+ * record length rounding fix are still read.
+ */
+#include "roundtrip.h"
+#include <algorithm>
+
+/**
+ * reads the events of the file in order, the events of the records
+ * listed in skipped must be missing, the event lastEvent may be wrong.
+ * Returns the number of errors.
+ */
+static long checkSkipped(const std::string& filename, bool mapped, std::vector<int> skipped,
+                         long lastEvent, long failedRecords) {
+  hipo::reader reader;
+  reader.setMemoryMapped(mapped);
+  reader.open(filename.c_str());
+  const hipo::readerIndex& index = reader.getIndex();
+
+  hipo::event event;
+  long        errors = 0;
+  for (int record = 0; record < index.getMaxRecords(); record++) {
+    bool missing = std::find(skipped.begin(), skipped.end(), record) != skipped.end();
+    for (long e = index.getFirstEvent(record); e < index.getFirstEvent(record + 1); e++) {
+      if (missing == true)
+        continue;
+      if (reader.hasNext() == false || reader.next(event) == false) {
+        std::cerr << "event " << e << " was not read" << std::endl;
+        return errors + 1;
+      }
+      if (e != lastEvent && roundtrip::checkEvent(event, e) == false)
+        errors++;
+    }
+  }
+  if (reader.hasNext() == true && reader.next(event) == true) {
+    std::cerr << "read more events than expected" << std::endl;
+    errors++;
+  }
+  if (reader.getFailedRecords() != failedRecords) {
+    std::cerr << reader.getFailedRecords() << " records failed, expected " << failedRecords
+              << std::endl;
+    errors++;
+  }
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "mmap_test.hipo";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+
+  long         errors = 0;
+  hipo::reader reader;
+  reader.setMemoryMapped(true);
+  reader.open(filename.c_str());
+  if (reader.isMemoryMapped() == false || reader.getIndex().getMaxRecords() < 3) {
+    std::cerr << "expected a memory mapped file with at least 3 records" << std::endl;
+    return 1;
+  }
+  errors += roundtrip::checkFile(reader, nevents);
+
+  // unknown compression type in the second record : its events are skipped
+  std::string corrupt   = filename + ".corrupt";
+  long        position  = reader.getIndex().getPosition(1);
+  int         lastEvent = reader.getIndex().getFirstEvent(1) - 1;
+  roundtrip::copyFile(filename, corrupt);
+  roundtrip::writeWord(corrupt, position + 36, 0x70000000);
+  for (int mapped = 0; mapped < 2; mapped++)
+    errors += checkSkipped(corrupt, mapped == 1, {1}, -1, 1);
+
+  // the first record ends 3 bytes short, as written with the old rounding
+  int bitInfo = roundtrip::recordWord(reader, 20);
+  roundtrip::copyFile(filename, corrupt);
+  roundtrip::writeWord(corrupt, reader.getIndex().getPosition(0) + 20, bitInfo | (3 << 24));
+  for (int mapped = 0; mapped < 2; mapped++)
+    errors += checkSkipped(corrupt, mapped == 1, {}, lastEvent, 0);
+  std::remove(corrupt.c_str());
+
+  printf("mmap_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
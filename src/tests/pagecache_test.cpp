@@ -0,0 +1,58 @@
+/*
+ * Page cache policies (reader::setPageCachePolicy). Streaming reads with
+ * access hints and O_DIRECT reads into aligned buffers (or streaming
+ * where the file system refuses O_DIRECT) must read the same events as
+ * the default policy, with and without read-ahead, in order and out of
+ * order, and when the policy changes while reading.
+ */
+#include "roundtrip.h"
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "pagecache_test.hipo";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+  long errors = 0;
+
+  int policies[] = {hipo::kPageCacheDefault, hipo::kPageCacheStreaming, hipo::kPageCacheDirect};
+  for (int policy : policies) {
+    for (int depth = 0; depth <= 2; depth += 2) {
+      hipo::reader reader;
+      reader.open(filename.c_str());
+      reader.setPageCachePolicy(policy);
+      reader.setPrefetch(depth);
+      long failed = roundtrip::checkFile(reader, nevents);
+
+      hipo::event event;
+      long        targets[] = {nevents - 1, 0, nevents / 2, 12345};
+      for (long target : targets) {
+        if (reader.readEvent(target, event) == false ||
+            roundtrip::checkEvent(event, target) == false)
+          failed++;
+      }
+      if (failed > 0) {
+        std::cerr << failed << " events wrong with policy " << policy << " and read-ahead "
+                  << depth << std::endl;
+        errors += failed;
+      }
+    }
+  }
+
+  // policy changed in the middle of a record
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  hipo::event event;
+  for (long n = 0; n < nevents; n++) {
+    if (n == 1000)
+      reader.setPageCachePolicy(hipo::kPageCacheDirect);
+    if (n == 150000)
+      reader.setPageCachePolicy(hipo::kPageCacheStreaming);
+    if (reader.next(event) == false || roundtrip::checkEvent(event, n) == false) {
+      std::cerr << "event " << n << " wrong after the policy changed" << std::endl;
+      errors++;
+      break;
+    }
+  }
+
+  printf("pagecache_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
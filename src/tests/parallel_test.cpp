@@ -0,0 +1,89 @@
+/*
+ * Processing the events of a file on several threads
+ * (reader::forEachParallel). Every event is processed once whatever the
+ * number of threads, the position of the reader does not change, and a
+ * record that can not be read is skipped and counted.
+ */
+#include "roundtrip.h"
+
+// per-thread state of the test, the banks are members as advised
+typedef struct {
+  long                        events = 0;
+  long                        sum    = 0;
+  long                        errors = 0;
+  std::shared_ptr<hipo::bank> header;
+} count_t;
+
+/**
+ * processes the file on nthreads threads, checks every event and returns
+ * the number of events processed and the sum of their numbers.
+ */
+static count_t process(hipo::reader& reader, int nthreads) {
+  return reader.forEachParallel(
+      nthreads, count_t(),
+      [](hipo::event& event, count_t& count) {
+        if (count.header == nullptr)
+          count.header = std::make_shared<hipo::bank>(roundtrip::eventSchema());
+        event.getStructure(*count.header);
+        long n = count.header->getLong("event", 0);
+        if (roundtrip::checkEvent(event, n) == false)
+          count.errors++;
+        count.events++;
+        count.sum += n;
+      },
+      [](count_t& total, count_t& count) {
+        total.events += count.events;
+        total.sum += count.sum;
+        total.errors += count.errors;
+      });
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "parallel_test.hipo";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+  long errors = 0;
+
+  for (int mapped = 0; mapped < 2; mapped++) {
+    hipo::reader reader;
+    reader.setMemoryMapped(mapped == 1);
+    reader.open(filename.c_str());
+    reader.gotoEvent(1234);
+    int threads[] = {1, 4, 0};
+    for (int nthreads : threads) {
+      count_t count = process(reader, nthreads);
+      if (count.events != nevents || count.sum != nevents * (nevents - 1) / 2 ||
+          count.errors != 0) {
+        std::cerr << nthreads << " threads : " << count.events << " events, " << count.errors
+                  << " errors" << std::endl;
+        errors++;
+      }
+    }
+    if (reader.getEventNumber() != 1234 || reader.getFailedRecords() != 0) {
+      std::cerr << "forEachParallel moved the reader or failed" << std::endl;
+      errors++;
+    }
+  }
+
+  // unknown compression type in the second record
+  std::string corrupt = filename + ".corrupt";
+  {
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    roundtrip::copyFile(filename, corrupt);
+    roundtrip::writeWord(corrupt, reader.getIndex().getPosition(1) + 36, 0x70000000);
+  }
+  hipo::reader reader;
+  reader.open(corrupt.c_str());
+  long    missing = reader.getIndex().getFirstEvent(2) - reader.getIndex().getFirstEvent(1);
+  count_t count   = process(reader, 4);
+  if (reader.getFailedRecords() != 1 || count.events != nevents - missing || count.errors != 0) {
+    std::cerr << "corrupt file : " << reader.getFailedRecords() << " records failed, "
+              << count.events << " events processed" << std::endl;
+    errors++;
+  }
+  std::remove(corrupt.c_str());
+
+  printf("parallel_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/*
+ * Background read-ahead of records (reader::setPrefetch). Events read
+ * with any depth, from the stream or the memory mapped file, must be the
+ * ones read without read-ahead, also when the reader jumps outside of
+ * the read-ahead window or the read-ahead is changed while reading.
+ */
+#include "roundtrip.h"
+
+/**
+ * reads events first to last-1 with next() and checks them, returns
+ * the number of errors.
+ */
+static long checkNext(hipo::reader& reader, long first, long last) {
+  hipo::event event;
+  for (long n = first; n < last; n++) {
+    if (reader.next(event) == false) {
+      std::cerr << "event " << n << " was not read" << std::endl;
+      return 1;
+    }
+    if (roundtrip::checkEvent(event, n) == false)
+      return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "prefetch_test.hipo";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+  long errors = 0;
+
+  int depths[] = {1, 3, 8};
+  for (int mapped = 0; mapped < 2; mapped++) {
+    for (int depth : depths) {
+      hipo::reader reader;
+      reader.setMemoryMapped(mapped == 1);
+      reader.open(filename.c_str());
+      reader.setPrefetch(depth);
+      errors += roundtrip::checkFile(reader, nevents);
+
+      // backwards and across the read-ahead window, next() goes on from there
+      hipo::event event;
+      long        targets[] = {nevents - 1, 1000, nevents / 2, 0, nevents - 2};
+      for (long target : targets) {
+        if (reader.readEvent(target, event) == false ||
+            roundtrip::checkEvent(event, target) == false) {
+          std::cerr << "can not read event " << target << " with depth " << depth << std::endl;
+          errors++;
+        }
+      }
+      errors += checkNext(reader, nevents - 1, nevents);
+    }
+  }
+
+  // read-ahead switched off and on again in the middle of a record
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  reader.setPrefetch(4);
+  errors += checkNext(reader, 0, 100000);
+  reader.setPrefetch(0);
+  errors += checkNext(reader, 100000, 150000);
+  reader.setPrefetch(2);
+  errors += checkNext(reader, 150000, nevents);
+  hipo::event event;
+  if (reader.next(event) == true) {
+    std::cerr << "read more events than expected" << std::endl;
+    errors++;
+  }
+
+  printf("prefetch_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
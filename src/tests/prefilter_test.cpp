@@ -0,0 +1,65 @@
+/*
+ * Column prefilters (writer::setPrefilter, bit 0x10000 of the record bit
+ * info) : encode/decode of an event buffer, and write/read round trips
+ * with each filter alone and both together.
+ */
+#include "roundtrip.h"
+#include "hipo4/prefilter.h"
+#include <cstring>
+
+/**
+ * encodes a few events in place and decodes them back, the encoded
+ * buffer must differ from the events and the decoded one must not.
+ */
+static long checkBuffer() {
+  hipo::dictionary dict;
+  dict.addSchema(roundtrip::eventSchema());
+  dict.addSchema(roundtrip::particleSchema());
+  hipo::prefilter filter;
+  filter.setFilters(dict, hipo::kPrefilterShuffle | hipo::kPrefilterDelta, {"status"});
+
+  std::vector<char> events;
+  hipo::event       event;
+  for (int n = 0; n < 20; n++) {
+    roundtrip::fillEvent(event, n);
+    events.insert(events.end(), event.getEventBuffer().begin(),
+                  event.getEventBuffer().begin() + event.getSize());
+  }
+  std::vector<char> buffer = events;
+  std::vector<char> layout;
+  filter.encode(&buffer[0], buffer.size(), layout);
+  if (layout.size() == 0 || buffer == events) {
+    std::cerr << "prefilter did not change the events" << std::endl;
+    return 1;
+  }
+  hipo::prefilter decoder;
+  decoder.decode(&buffer[0], buffer.size(), &layout[0], layout.size());
+  if (buffer != events) {
+    std::cerr << "prefilter decode does not restore the events" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "prefilter_test.hipo";
+  long        nevents  = 50000;
+  long        errors   = checkBuffer();
+
+  int flags[] = {hipo::kPrefilterShuffle, hipo::kPrefilterDelta,
+                 hipo::kPrefilterShuffle | hipo::kPrefilterDelta};
+  for (int f : flags) {
+    roundtrip::writeFile(filename, nevents, [f](hipo::writer& writer) {
+      writer.setPrefilter(f, {"pid", "status"});
+    });
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    if ((roundtrip::recordWord(reader, 20) & hipo::prefilter::recordBit) == 0) {
+      std::cerr << "records written with filters " << f << " are not prefiltered" << std::endl;
+      errors++;
+    }
+    errors += roundtrip::checkFile(reader, nevents);
+  }
+  printf("prefilter_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/*
+ * Cache of decompressed records (hipo::recordCache, reader::setCacheSize).
+ * The least recently used records are evicted to keep the cache within
+ * its memory size, a record held by a caller stays valid after it is
+ * evicted, and the hit and miss counters of the reader follow the
+ * records read out of order.
+ */
+#include "roundtrip.h"
+#include "hipo4/recordcache.h"
+#include <algorithm>
+
+/**
+ * true if the record holds the first event of record number r.
+ */
+static bool checkRecord(std::shared_ptr<hipo::record> rec, hipo::reader& reader, int r) {
+  if (rec == nullptr)
+    return false;
+  hipo::event event;
+  rec->readHipoEvent(event, 0);
+  return roundtrip::checkEvent(event, reader.getIndex().getFirstEvent(r));
+}
+
+/**
+ * fills a cache holding two records with records 0 to 2 of the file.
+ * Returns the number of errors.
+ */
+static long checkEviction(hipo::reader& reader) {
+  std::ifstream                              stream(reader.getFileName().c_str(), std::ios::binary);
+  std::vector<std::shared_ptr<hipo::record>> records;
+  long                                       size = 0;
+  for (int r = 0; r < 3; r++) {
+    records.push_back(std::make_shared<hipo::record>());
+    reader.readRecord(*records[r], stream, reader.getIndex().getPosition(r));
+    size = std::max(size, records[r]->getMemorySize());
+  }
+  hipo::recordCache cache;
+  cache.setMaxSize(size * 5 / 2);
+  cache.insert(100, records[0]);
+  cache.insert(200, records[1]);
+  long errors = 0;
+  if (cache.getEntries() != 2 || cache.find(100) != records[0]) {
+    std::cerr << "cache does not hold the first two records" << std::endl;
+    errors++;
+  }
+  // record 1 is the least recently used one now
+  cache.insert(300, records[2]);
+  records.clear();
+  std::shared_ptr<hipo::record> first = cache.find(100);
+  std::shared_ptr<hipo::record> third = cache.find(300);
+  if (cache.find(200) != nullptr || checkRecord(first, reader, 0) == false ||
+      checkRecord(third, reader, 2) == false) {
+    std::cerr << "wrong record evicted" << std::endl;
+    errors++;
+  }
+  if (cache.getHits() != 3 || cache.getMisses() != 1 || cache.getSize() > size * 5 / 2) {
+    std::cerr << "cache has " << cache.getHits() << " hits, " << cache.getMisses()
+              << " misses and " << cache.getSize() << " bytes" << std::endl;
+    errors++;
+  }
+
+  // a held record survives its eviction
+  cache.setMaxSize(0);
+  if (cache.getEntries() != 0 || checkRecord(first, reader, 0) == false) {
+    std::cerr << "record not valid after the cache was disabled" << std::endl;
+    errors++;
+  }
+  return errors;
+}
+
+/**
+ * reads events of records 0 and 2 in turn, the cache holds both records
+ * if it has room for three. Returns the number of errors.
+ */
+static long checkReader(const std::string& filename, long cacheSize, long hits) {
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  reader.setCacheSize(cacheSize);
+  const hipo::readerIndex& index  = reader.getIndex();
+  long                     errors = 0;
+  hipo::event              event;
+  for (int i = 0; i < 20; i++) {
+    long n = index.getFirstEvent((i % 2) * 2) + i;
+    if (reader.readEvent(n, event) == false || roundtrip::checkEvent(event, n) == false)
+      errors++;
+  }
+  if (reader.getCacheHits() != hits || reader.getCacheMisses() != 20 - hits) {
+    std::cerr << "cache of " << cacheSize << " bytes has " << reader.getCacheHits() << " hits and "
+              << reader.getCacheMisses() << " misses" << std::endl;
+    errors++;
+  }
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "recordcache_test.hipo";
+  long        nevents  = 400000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  if (reader.getIndex().getMaxRecords() < 3) {
+    std::cerr << "expected a file with at least 3 records" << std::endl;
+    return 1;
+  }
+  long errors = checkEviction(reader);
+
+  // one record fits : the record read last is always kept, never the other
+  std::shared_ptr<hipo::record> rec = std::make_shared<hipo::record>();
+  std::ifstream                 stream(filename.c_str(), std::ios::binary);
+  reader.readRecord(*rec, stream, reader.getIndex().getPosition(0));
+  errors += checkReader(filename, rec->getMemorySize(), 0);
+  errors += checkReader(filename, 3 * rec->getMemorySize(), 18);
+
+  printf("recordcache_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/*
+ * Helpers of the write/read round-trip tests of the record formats.
+ * Every test writes events with a known content using one writer
+ * option, checks that the records carry the matching flag and reads
+ * the events back.
+ */
+#ifndef HIPO_TESTS_ROUNDTRIP_H
+#define HIPO_TESTS_ROUNDTRIP_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+// Hipo libs
+#include "hipo4/reader.h"
+#include "hipo4/writer.h"
+
+namespace roundtrip {
+
+  inline hipo::schema particleSchema() {
+    hipo::schema schema("REC::Particle", 300, 31);
+    schema.parse("pid/I,px/F,py/F,pz/F,charge/B,status/S");
+    return schema;
+  }
+
+  inline hipo::schema eventSchema() {
+    hipo::schema schema("REC::Event", 300, 1);
+    schema.parse("run/I,event/L,startTime/F");
+    return schema;
+  }
+
+  inline int particleRows(long n) { return 1 + n % 7; }
+
+  /**
+   * fills the event with number n : one REC::Event row and 1 to 7
+   * REC::Particle rows, all values derived from n.
+   */
+  inline void fillEvent(hipo::event& event, long n) {
+    hipo::bank header(eventSchema(), 1);
+    header.putInt("run", 0, 5038);
+    header.putLong("event", 0, n);
+    header.putFloat("startTime", 0, n * 0.25f);
+
+    int        rows = particleRows(n);
+    hipo::bank particles(particleSchema(), rows);
+    for (int r = 0; r < rows; r++) {
+      particles.putInt("pid", r, (r == 0 && n % 3 == 0) ? 11 : 211);
+      particles.putFloat("px", r, n * 0.5f + r);
+      particles.putFloat("py", r, -r);
+      particles.putFloat("pz", r, (float)(n % 10));
+      particles.putByte("charge", r, (int8_t)(r % 3 - 1));
+      particles.putShort("status", r, (int16_t)(n % 5000 - 2500));
+    }
+    event.reset();
+    event.addStructure(header);
+    event.addStructure(particles);
+  }
+
+  /**
+   * writes nevents events with fillEvent(), configure sets the writer
+   * option tested before the file is opened.
+   */
+  inline void writeFile(const std::string& filename, long nevents,
+                        std::function<void(hipo::writer&)> configure) {
+    hipo::writer writer;
+    writer.getDictionary().addSchema(eventSchema());
+    writer.getDictionary().addSchema(particleSchema());
+    configure(writer);
+    writer.open(filename);
+    hipo::event event;
+    for (long n = 0; n < nevents; n++) {
+      fillEvent(event, n);
+      writer.addEvent(event);
+    }
+    writer.close();
+  }
+
+  /**
+   * returns the word at given byte offset of the header of the first
+   * data record of the file (20 : bit info, 36 : compression word).
+   */
+  inline int recordWord(hipo::reader& reader, int offset) {
+    std::ifstream stream(reader.getFileName().c_str(), std::ios::binary);
+    int           word = 0;
+    stream.seekg(reader.getIndex().getPosition(0) + offset, std::ios::beg);
+    stream.read(reinterpret_cast<char*>(&word), 4);
+    return word;
+  }
+
+  /**
+   * overwrites the word at given byte position of the file, used to
+   * corrupt a copy of a file written by writeFile().
+   */
+  inline void writeWord(const std::string& filename, long position, int word) {
+    std::fstream stream(filename.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+    stream.seekp(position, std::ios::beg);
+    stream.write(reinterpret_cast<const char*>(&word), 4);
+  }
+
+  /**
+   * copies the file, so the copy can be corrupted with writeWord().
+   */
+  inline void copyFile(const std::string& filename, const std::string& copy) {
+    std::ifstream source(filename.c_str(), std::ios::binary);
+    std::ofstream target(copy.c_str(), std::ios::binary);
+    target << source.rdbuf();
+  }
+
+  /**
+   * true if both files have the same bytes, writer options that only
+   * change how records are produced must not change the file.
+   */
+  inline bool sameFile(const std::string& filename, const std::string& other) {
+    std::ifstream     a(filename.c_str(), std::ios::binary);
+    std::ifstream     b(other.c_str(), std::ios::binary);
+    std::vector<char> bytesA((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+    std::vector<char> bytesB((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+    return bytesA.size() > 0 && bytesA == bytesB;
+  }
+
+  /**
+   * reads the first data record of the file with the word at given byte
+   * offset of the record replaced. Returns false if the record is
+   * rejected and left empty, true if it is read anyway.
+   */
+  inline bool readCorrupted(const std::string& filename, int offset, int word) {
+    std::string copy = filename + ".corrupt";
+    copyFile(filename, copy);
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    long position = reader.getIndex().getPosition(0);
+    writeWord(copy, position + offset, word);
+
+    std::ifstream stream(copy.c_str(), std::ios::binary);
+    hipo::record  rec;
+    bool          status = reader.readRecord(rec, stream, position);
+    if (status == false && rec.getEventCount() != 0)
+      std::cerr << "failed record still has " << rec.getEventCount() << " events" << std::endl;
+    std::remove(copy.c_str());
+    return status == true || rec.getEventCount() != 0;
+  }
+
+  /**
+   * checks that the banks hold the content written by fillEvent(n), no
+   * particles if particles is false. Prints the first mismatch.
+   */
+  inline bool checkBanks(hipo::bank& header, hipo::bank& bank, long n, bool particles = true) {
+    if (header.getRows() != 1 || header.getLong("event", 0) != n) {
+      std::cerr << "event " << n << " : wrong REC::Event bank" << std::endl;
+      return false;
+    }
+    int rows = particles ? particleRows(n) : 0;
+    if (bank.getRows() != rows) {
+      std::cerr << "event " << n << " : " << bank.getRows() << " particles, expected " << rows
+                << std::endl;
+      return false;
+    }
+    for (int r = 0; r < rows; r++) {
+      if (bank.getInt("pid", r) != ((r == 0 && n % 3 == 0) ? 11 : 211) ||
+          bank.getFloat("px", r) != n * 0.5f + r || bank.getFloat("py", r) != -r ||
+          bank.getFloat("pz", r) != (float)(n % 10) || bank.getByte("charge", r) != r % 3 - 1 ||
+          bank.getShort("status", r) != n % 5000 - 2500) {
+        std::cerr << "event " << n << " : wrong REC::Particle row " << r << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * checks that the event holds the content written by fillEvent(n),
+   * only REC::Event if particles is false. Prints the first mismatch.
+   */
+  inline bool checkEvent(hipo::event& event, long n, bool particles = true) {
+    hipo::bank header(eventSchema());
+    hipo::bank bank(particleSchema());
+    event.getStructure(header);
+    event.getStructure(bank);
+    return checkBanks(header, bank, n, particles);
+  }
+
+  /**
+   * reads all events of the reader in order and checks them, returns
+   * the number of events that are wrong or missing.
+   */
+  inline long checkFile(hipo::reader& reader, long nevents, bool particles = true) {
+    hipo::event event;
+    long        n      = 0;
+    long        errors = 0;
+    while (reader.hasNext() == true) {
+      if (reader.next(event) == false || checkEvent(event, n, particles) == false)
+        errors++;
+      n++;
+    }
+    if (n != nevents) {
+      std::cerr << "read " << n << " events, expected " << nevents << std::endl;
+      errors += std::abs(nevents - n);
+    }
+    return errors;
+  }
+} // namespace roundtrip
+#endif /* HIPO_TESTS_ROUNDTRIP_H */
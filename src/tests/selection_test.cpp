@@ -0,0 +1,113 @@
+/*
+ * Column kernels of the row selection (selectColumn). The AVX2 and SSE4.1
+ * kernels must select the same rows as the scalar loop, also for the
+ * smallest integers (no absolute value in the type), NaN, empty ranges
+ * and ranges with low above high. Kernels the CPU does not support are
+ * skipped.
+ */
+#include "hipo4/selection.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+
+/**
+ * conditions of every kind over values around the limits of type T.
+ */
+template <typename T> static std::vector<hipo::selectionCondition_t> conditions() {
+  double          min = (double)std::numeric_limits<T>::lowest();
+  double          max = (double)std::numeric_limits<T>::max();
+  hipo::selection sel;
+  sel.range("a", -3, 7).range("a", 7, -3).range("a", 5, 5).range("a", min, max);
+  sel.range("a", -INFINITY, INFINITY).range("a", NAN, 10).range("a", 0, NAN);
+  sel.absRange("a", 2, 100).absRange("a", -max, -min + 1).absRange("a", -min, -min + 1);
+  sel.absRange("a", 0.5, 1.5).absRange("a", 9, 2);
+  sel.equal("a", min).equal("a", 0).notEqual("a", min).notEqual("a", 1.5);
+  sel.less("a", -1).lessEqual("a", max).greater("a", max).greaterEqual("a", min + 1);
+
+  std::vector<hipo::selectionCondition_t> result;
+  for (int i = 0; i < sel.getConditions(); i++) {
+    result.push_back(sel.getCondition(i));
+    result.push_back(sel.getCondition(i));
+    result.back().invert = !result.back().invert;
+  }
+  return result;
+}
+
+/**
+ * column with the limits of type T (and NaN, infinities for floating
+ * point types) followed by values cycling around 0.
+ */
+template <typename T> static std::vector<T> column(int rows) {
+  std::vector<T> special = {std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max(),
+                            (T)0, (T)-1, (T)1, (T)(std::numeric_limits<T>::lowest() + 1)};
+  if (std::numeric_limits<T>::has_quiet_NaN) {
+    special.push_back(std::numeric_limits<T>::quiet_NaN());
+    special.push_back(std::numeric_limits<T>::infinity());
+    special.push_back(-std::numeric_limits<T>::infinity());
+    special.push_back((T)-0.0);
+    special.push_back((T)1.5);
+  }
+  std::vector<T> values(rows);
+  for (int r = 0; r < rows; r++)
+    values[r] = (r % 3 == 0) ? special[(r / 3) % special.size()] : (T)(r % 23 - 11);
+  return values;
+}
+
+/**
+ * selects each condition with every kernel, over columns of lengths that
+ * leave a tail for the scalar loop. Returns the number of mismatches.
+ */
+template <typename T> static long checkType(const char* name) {
+  long errors    = 0;
+  int  lengths[] = {0, 1, 3, 4, 7, 16, 31, 33, 100, 257};
+  for (int rows : lengths) {
+    std::vector<T> values = column<T>(rows);
+    for (const hipo::selectionCondition_t& c : conditions<T>()) {
+      hipo::setSelectKernel(hipo::kSelectScalar);
+      std::vector<uint8_t> expected(rows + 1, 1);
+      hipo::selectColumn(values.data(), rows, c, expected.data());
+
+      for (int kernel = hipo::kSelectSSE41; kernel <= hipo::kSelectAVX2; kernel++) {
+        if (hipo::setSelectKernel(kernel) != kernel)
+          continue;
+        std::vector<uint8_t> mask(rows + 1, 1);
+        hipo::selectColumn(values.data(), rows, c, mask.data());
+        if (mask != expected) {
+          std::cerr << name << " : kernel " << kernel << " differs from the scalar loop for "
+                    << rows << " rows, range [" << c.low << "," << c.high << ") absolute "
+                    << c.absolute << " invert " << c.invert << std::endl;
+          errors++;
+        }
+      }
+    }
+  }
+  hipo::setSelectKernel(hipo::kSelectAVX2);
+  return errors;
+}
+
+int main() {
+  long errors = 0;
+  errors += checkType<int8_t>("int8");
+  errors += checkType<int16_t>("int16");
+  errors += checkType<int32_t>("int32");
+  errors += checkType<float>("float");
+  errors += checkType<double>("double");
+  errors += checkType<int64_t>("int64");
+
+  // |INT8_MIN| is 128, it is outside of [0, 128) and inside of [128, 129)
+  std::vector<int8_t> values = column<int8_t>(64);
+  hipo::selection     sel;
+  sel.absRange("a", 0, 128).absRange("a", 128, 129);
+  for (int i = 0; i < 2; i++) {
+    std::vector<uint8_t> mask(values.size(), 1);
+    hipo::selectColumn(values.data(), values.size(), sel.getCondition(i), mask.data());
+    if (mask[0] != i || mask[1] != 1 - i) {
+      std::cerr << "INT8_MIN and INT8_MAX are not selected by absolute range " << i << std::endl;
+      errors++;
+    }
+  }
+
+  printf("selection_test : kernel %d, %ld errors\n", hipo::getSelectKernel(), errors);
+  return errors == 0 ? 0 : 1;
+}
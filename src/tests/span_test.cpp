@@ -0,0 +1,61 @@
+/*
+ * Column spans and bulk copies (bank::getSpan, bank::copyColumn). Spans
+ * see the column data in place, copies convert to the requested type,
+ * and a wrong column name or type gives an empty span and no copy.
+ */
+#include "roundtrip.h"
+
+int main() {
+  long errors = 0;
+
+  hipo::bank  particles(roundtrip::particleSchema());
+  hipo::event event;
+  for (long n = 0; n < 100; n++) {
+    roundtrip::fillEvent(event, n);
+    event.getStructure(particles);
+    int rows = particles.getRows();
+
+    hipo::span<int32_t> pid    = particles.getSpan<int32_t>("pid");
+    hipo::span<float>   px     = particles.getSpan<float>("px");
+    hipo::span<int16_t> status = particles.getSpan<int16_t>(5);
+    if (pid.size() != rows || px.size() != rows || status.size() != rows) {
+      std::cerr << "event " << n << " : spans do not have " << rows << " rows" << std::endl;
+      errors++;
+      continue;
+    }
+
+    std::vector<int32_t> pids(rows);
+    std::vector<int32_t> charges(rows);
+    std::vector<float>   statuses(rows);
+    std::vector<double>  pxs(rows);
+    if (particles.copyColumn<int32_t>("pid", &pids[0]) != rows ||
+        particles.copyColumn<int32_t>("charge", &charges[0]) != rows ||
+        particles.copyColumn<float>("status", &statuses[0]) != rows ||
+        particles.copyColumn<double>("px", &pxs[0]) != rows) {
+      std::cerr << "event " << n << " : columns not copied" << std::endl;
+      errors++;
+      continue;
+    }
+    for (int r = 0; r < rows; r++) {
+      if (pid[r] != particles.getInt("pid", r) || px[r] != particles.getFloat("px", r) ||
+          status[r] != particles.getShort("status", r) || pids[r] != pid[r] ||
+          charges[r] != particles.getByte("charge", r) || statuses[r] != (float)status[r] ||
+          pxs[r] != (double)px[r]) {
+        std::cerr << "event " << n << " : wrong value in row " << r << std::endl;
+        errors++;
+      }
+    }
+  }
+
+  // wrong name and wrong type
+  float buffer[16];
+  if (particles.getSpan<float>("energy").empty() == false ||
+      particles.getSpan<int32_t>("px").empty() == false ||
+      particles.copyColumn<float>("energy", buffer) != 0) {
+    std::cerr << "wrong columns are not reported" << std::endl;
+    errors++;
+  }
+
+  printf("span_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+/*
+ * Write/read round trip of the per-record column statistics
+ * (writer::addStatistics, banks 32111/2-3 of the file index). Records
+ * outside the range of a reader filter must be skipped, the events in
+ * the range must all be read.
+ */
+#include "roundtrip.h"
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "statistics_test.hipo";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {
+    writer.addStatistics("REC::Event", "event");
+    writer.addStatistics("REC::Particle");
+  });
+
+  long errors = 0;
+  {
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    if (reader.getIndex().getMaxRecords() < 3) {
+      std::cerr << "expected at least 3 records" << std::endl;
+      return 1;
+    }
+    errors += roundtrip::checkFile(reader, nevents);
+  }
+
+  long         first = 230000;
+  long         last  = 230100;
+  hipo::reader reader;
+  reader.addFilter("REC::Event", "event", first, last);
+  reader.open(filename.c_str());
+  hipo::event event;
+  hipo::bank  header(roundtrip::eventSchema());
+  long        nread  = 0;
+  long        inside = 0;
+  while (reader.hasNext() == true && reader.next(event) == true) {
+    event.getStructure(header);
+    long n = header.getLong("event", 0);
+    if (roundtrip::checkEvent(event, n) == false)
+      errors++;
+    if (n >= first && n <= last)
+      inside++;
+    nread++;
+  }
+  if (inside != last - first + 1 || nread >= nevents) {
+    std::cerr << "filter read " << nread << " events, " << inside << " in range" << std::endl;
+    errors++;
+  }
+  printf("statistics_test : read %ld of %ld events, %ld errors\n", nread, nevents, errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/*
+ * Tagged record streams (writer::addEvent(event, tag), reader::setTags).
+ * Every tag is written to its own records with the tag as user word one,
+ * a reader with tags set reads only the events of these tags, each tag
+ * in the order its events were added, a reader without tags reads all.
+ */
+#include "roundtrip.h"
+#include <algorithm>
+
+static long eventTag(long n) { return (n % 50 == 0) ? 2 : (n % 7 == 0) ? 5 : 0; }
+
+/**
+ * next event after n with the tag, nevents if there is none.
+ */
+static long nextEvent(long n, long tag, long nevents) {
+  for (n++; n < nevents; n++)
+    if (eventTag(n) == tag)
+      break;
+  return n;
+}
+
+/**
+ * reads the events of the file and checks that they are all the events
+ * of the given tags, each tag in order (the records of different tags
+ * follow each other). Returns the number of errors.
+ */
+static long checkTags(const std::string& filename, long nevents, const std::vector<long>& tags) {
+  hipo::reader reader;
+  for (long tag : tags)
+    reader.setTags(tag);
+  reader.open(filename.c_str());
+
+  // next event expected for every tag
+  std::vector<long> expected;
+  for (long tag : tags)
+    expected.push_back(nextEvent(-1, tag, nevents));
+
+  hipo::event event;
+  hipo::bank  header(roundtrip::eventSchema());
+  while (reader.next(event) == true) {
+    event.getStructure(header);
+    long n = header.getLong("event", 0);
+    long t = std::find(tags.begin(), tags.end(), eventTag(n)) - tags.begin();
+    if (t == (long)tags.size() || n != expected[t] || roundtrip::checkEvent(event, n) == false) {
+      std::cerr << "event " << n << " read with " << tags.size() << " tags" << std::endl;
+      return 1;
+    }
+    expected[t] = nextEvent(n, tags[t], nevents);
+  }
+  for (int t = 0; t < (int)tags.size(); t++) {
+    if (expected[t] != nevents) {
+      std::cerr << "event " << expected[t] << " with tag " << tags[t] << " was not read"
+                << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "tags_test.hipo";
+  long        nevents  = 500000;
+  long        errors   = 0;
+
+  hipo::writer writer;
+  writer.getDictionary().addSchema(roundtrip::eventSchema());
+  writer.getDictionary().addSchema(roundtrip::particleSchema());
+  writer.open(filename);
+  hipo::event event;
+  for (long n = 0; n < nevents; n++) {
+    roundtrip::fillEvent(event, n);
+    writer.addEvent(event, eventTag(n));
+  }
+  writer.close();
+
+  errors += checkTags(filename, nevents, {2});
+  errors += checkTags(filename, nevents, {5});
+  errors += checkTags(filename, nevents, {2, 5});
+  errors += checkTags(filename, nevents, {0});
+
+  // without tags all records are read, grouped by tag
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  std::vector<long> counts(6, 0);
+  while (reader.next(event) == true) {
+    hipo::bank header(roundtrip::eventSchema());
+    event.getStructure(header);
+    counts[eventTag(header.getLong("event", 0))]++;
+  }
+  if (counts[2] != nevents / 50 || counts[0] + counts[2] + counts[5] != nevents) {
+    std::cerr << "read " << counts[0] << ", " << counts[2] << " and " << counts[5]
+              << " events with tags 0, 2 and 5" << std::endl;
+    errors++;
+  }
+
+  printf("tags_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
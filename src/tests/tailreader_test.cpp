@@ -0,0 +1,90 @@
+/*
+ * Reading a file while it is written (hipo::tailReader). The file is
+ * copied in pieces by another thread and the tail reader must return
+ * every event once. A complete record that can not be read is skipped
+ * and counted, not read again.
+ */
+#include "roundtrip.h"
+#include "hipo4/tailreader.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/**
+ * reads the file with the tail reader, the events of the record skipped
+ * (if >= 0) must be missing. Returns the number of errors.
+ */
+static long checkTail(const std::string& filename, hipo::reader& reader, int skipped,
+                      long failedRecords) {
+  hipo::tailReader tail;
+  if (tail.open(filename.c_str()) == false) {
+    std::cerr << "can not open " << filename << std::endl;
+    return 1;
+  }
+  tail.setPollInterval(5);
+  tail.setTimeout(10);
+
+  const hipo::readerIndex& index  = reader.getIndex();
+  hipo::event              event;
+  long                     errors = 0;
+  for (int record = 0; record < index.getMaxRecords(); record++) {
+    if (record == skipped)
+      continue;
+    for (long e = index.getFirstEvent(record); e < index.getFirstEvent(record + 1); e++) {
+      if (tail.next(event) == false) {
+        std::cerr << "event " << e << " was not read" << std::endl;
+        return errors + 1;
+      }
+      if (roundtrip::checkEvent(event, e) == false)
+        errors++;
+    }
+  }
+  if (tail.next(event) == true || tail.isFinished() == false) {
+    std::cerr << "tail reader did not stop at the end of the file" << std::endl;
+    errors++;
+  }
+  if (tail.getFailedRecords() != failedRecords) {
+    std::cerr << tail.getFailedRecords() << " records failed, expected " << failedRecords
+              << std::endl;
+    errors++;
+  }
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "tailreader_test.hipo";
+  std::string growing  = filename + ".growing";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  long errors = 0;
+
+  // the copy grows by 256 KB pieces while it is read
+  std::remove(growing.c_str());
+  std::atomic<bool> started(false);
+  std::thread       writer([&filename, &growing, &started] {
+    std::ifstream     source(filename.c_str(), std::ios::binary);
+    std::ofstream     target(growing.c_str(), std::ios::binary);
+    std::vector<char> piece(256 * 1024);
+    while (source.read(&piece[0], piece.size()) || source.gcount() > 0) {
+      target.write(&piece[0], source.gcount());
+      target.flush();
+      started = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  });
+  while (started == false)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  errors += checkTail(growing, reader, -1, 0);
+  writer.join();
+
+  // unknown compression type in the second record
+  roundtrip::writeWord(growing, reader.getIndex().getPosition(1) + 36, 0x70000000);
+  errors += checkTail(growing, reader, 1, 1);
+  std::remove(growing.c_str());
+
+  printf("tailreader_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+/*
+ * Read-ahead with batched io_uring reads (reader::setAsyncIO). The
+ * records of the read-ahead window are read in one batch with the
+ * lengths of the file index, a record that can not be decoded is
+ * skipped and counted. Where io_uring is not available (not compiled
+ * in or refused by the kernel) the same reads go through the stream.
+ */
+#include "roundtrip.h"
+#include "hipo4/uring.h"
+
+/**
+ * reads the file with a read-ahead of depth records, with and without
+ * io_uring, and then a few events out of order. The first skipped events
+ * are missing. Returns the number of errors.
+ */
+static long checkAsync(const std::string& filename, long nevents, int depth, long skipped,
+                       long failedRecords) {
+  long errors = 0;
+  for (int async = 0; async < 2; async++) {
+    hipo::reader reader;
+    reader.open(filename.c_str());
+    reader.setPrefetch(depth);
+    reader.setAsyncIO(async == 1);
+
+    hipo::event event;
+    for (long n = skipped; n < nevents; n++) {
+      if (reader.hasNext() == false || reader.next(event) == false) {
+        std::cerr << "event " << n << " was not read, async " << async << std::endl;
+        return errors + 1;
+      }
+      if (roundtrip::checkEvent(event, n) == false)
+        errors++;
+    }
+    if (reader.hasNext() == true && reader.next(event) == true) {
+      std::cerr << "read more events than expected, async " << async << std::endl;
+      errors++;
+    }
+    long targets[] = {nevents - 1, skipped, (skipped + nevents) / 2};
+    for (long target : targets) {
+      if (reader.readEvent(target, event) == false ||
+          roundtrip::checkEvent(event, target) == false) {
+        std::cerr << "can not read event " << target << ", async " << async << std::endl;
+        errors++;
+      }
+    }
+    if (reader.getFailedRecords() != failedRecords) {
+      std::cerr << reader.getFailedRecords() << " records failed, expected " << failedRecords
+                << ", async " << async << std::endl;
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  std::string filename = (argc >= 2) ? argv[1] : "uring_test.hipo";
+  long        nevents  = 250000;
+  roundtrip::writeFile(filename, nevents, [](hipo::writer& writer) {});
+  printf("uring_test : io_uring %s\n",
+         hipo::uringReader::isAvailable() ? "available" : "not available");
+
+  long         errors = 0;
+  hipo::reader reader;
+  reader.open(filename.c_str());
+  const hipo::readerIndex& index = reader.getIndex();
+  if (index.getMaxRecords() < 3) {
+    std::cerr << "expected a file with at least 3 records" << std::endl;
+    return 1;
+  }
+  for (int depth : {1, 4})
+    errors += checkAsync(filename, nevents, depth, 0, 0);
+
+  // unknown compression type in the first record : its events are skipped
+  std::string corrupt = filename + ".corrupt";
+  roundtrip::copyFile(filename, corrupt);
+  roundtrip::writeWord(corrupt, index.getPosition(0) + 36, 0x70000000);
+  errors += checkAsync(corrupt, nevents, 4, index.getFirstEvent(1), 1);
+
+  // record length that does not match the file index : the batch is read again with the stream
+  int length = roundtrip::recordWord(reader, 0);
+  roundtrip::copyFile(filename, corrupt);
+  roundtrip::writeWord(corrupt, index.getPosition(0), length + 1);
+  errors += checkAsync(corrupt, nevents, 4, 0, 0);
+  std::remove(corrupt.c_str());
+
+  printf("uring_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
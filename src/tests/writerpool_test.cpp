@@ -0,0 +1,54 @@
+/*
+ * Compressing records with a pool of writer threads
+ * (writer::setCompressionThreads). Records are written in the order they
+ * were filled, with their index entries, so the file must have the same
+ * bytes as a file written inline whatever the number of threads and the
+ * record options.
+ */
+#include "roundtrip.h"
+#include "hipo4/prefilter.h"
+
+int main(int argc, char** argv) {
+  std::string prefix  = (argc >= 2) ? argv[1] : "writerpool_test";
+  std::string inlined = prefix + "_inline.hipo";
+  std::string pool    = prefix + "_pool.hipo";
+  long        nevents = 400000;
+  long        errors  = 0;
+
+  std::vector<std::function<void(hipo::writer&)>> options = {
+      [](hipo::writer& writer) {},
+      [](hipo::writer& writer) {
+        writer.setColumnar(true);
+        writer.setPrefilter(hipo::kPrefilterShuffle);
+      },
+      [](hipo::writer& writer) {
+        writer.setCompression("lz4hc", 4);
+        writer.addStatistics("REC::Particle", "px");
+      }};
+  int threads[] = {2, 3, 8};
+  for (int o = 0; o < (int)options.size(); o++) {
+    roundtrip::writeFile(inlined, nevents, options[o]);
+    for (int n : threads) {
+      roundtrip::writeFile(pool, nevents, [&options, o, n](hipo::writer& writer) {
+        options[o](writer);
+        writer.setCompressionThreads(n);
+      });
+      if (roundtrip::sameFile(inlined, pool) == false) {
+        std::cerr << "file written with " << n << " threads differs from the inline one, options "
+                  << o << std::endl;
+        errors++;
+      }
+    }
+  }
+  hipo::reader reader;
+  reader.open(pool.c_str());
+  if (reader.getIndex().getMaxRecords() < 4) {
+    std::cerr << "expected at least 4 records" << std::endl;
+    errors++;
+  }
+  errors += roundtrip::checkFile(reader, nevents);
+  std::remove(inlined.c_str());
+
+  printf("writerpool_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
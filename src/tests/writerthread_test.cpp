@@ -0,0 +1,46 @@
+/*
+ * Compressing and writing records in a background thread
+ * (writer::setBackground). The file must have the same bytes as a file
+ * written inline, also when the writer is destroyed without close().
+ */
+#include "roundtrip.h"
+
+int main(int argc, char** argv) {
+  std::string prefix  = (argc >= 2) ? argv[1] : "writerthread_test";
+  std::string inlined = prefix + "_inline.hipo";
+  std::string thread  = prefix + "_thread.hipo";
+  long        nevents = 250000;
+  long        errors  = 0;
+
+  roundtrip::writeFile(inlined, nevents, [](hipo::writer& writer) {});
+  roundtrip::writeFile(thread, nevents, [](hipo::writer& writer) { writer.setBackground(true); });
+  if (roundtrip::sameFile(inlined, thread) == false) {
+    std::cerr << "file written in the background differs from the inline one" << std::endl;
+    errors++;
+  }
+
+  // the destructor closes the file and waits for the records queued
+  {
+    hipo::writer writer;
+    writer.getDictionary().addSchema(roundtrip::eventSchema());
+    writer.getDictionary().addSchema(roundtrip::particleSchema());
+    writer.setBackground(true);
+    writer.open(thread);
+    hipo::event event;
+    for (long n = 0; n < nevents; n++) {
+      roundtrip::fillEvent(event, n);
+      writer.addEvent(event);
+    }
+  }
+  if (roundtrip::sameFile(inlined, thread) == false) {
+    std::cerr << "file not closed by the writer destructor" << std::endl;
+    errors++;
+  }
+  hipo::reader reader;
+  reader.open(thread.c_str());
+  errors += roundtrip::checkFile(reader, nevents);
+  std::remove(inlined.c_str());
+
+  printf("writerthread_test : %ld errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
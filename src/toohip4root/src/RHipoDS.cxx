@@ -8,6 +8,7 @@
 #include <ROOT/RMakeUnique.hxx>
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 namespace ROOT {
@@ -129,11 +130,9 @@ std::vector<std::pair<ULong64_t, ULong64_t>> RHipoDS::GetEntryRanges()
 
 bool RHipoDS::SetEntry(unsigned int slot, ULong64_t entry)
 {
-  while(fChains[slot]->getCurrentEvent() > entry) {
-    fChains[slot]->next();
-  }
-  //fChains[slot]->GetEntry(entry);
-  return true;
+  if (entry > (ULong64_t)std::numeric_limits<long>::max())
+    return false;
+  return fChains[slot]->gotoEvent((long)entry);
 }
 
 void RHipoDS::SetNSlots(unsigned int nSlots)